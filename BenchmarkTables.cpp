@@ -0,0 +1,21 @@
+#include "BenchmarkTables.h"
+#include <cstdlib>
+
+LifeSpan generate_life_span() {
+    uint32_t start = std::rand() % (NUMBER_OF_VERSIONS-1);
+    uint32_t life_span = std::rand() % LIFETIME + 1;
+    uint32_t end = start + life_span;
+
+    LifeSpan result{start, end};
+    if(end >= NUMBER_OF_VERSIONS) result.end = std::nullopt;
+
+    return result;
+}
+
+void init_random_temporal_table(TemporalTable& table) {
+    for (int i=0; i<TEMPORAL_TABLE_SIZE; ++i) {
+        Tuple tuple{std::rand() % DISTINCT_VALUES + 1};
+        LifeSpan lifespan = generate_life_span();
+        table.tuples.emplace_back(tuple, lifespan);
+    }
+}
@@ -0,0 +1,23 @@
+#include "TemporalTable.h"
+
+#ifndef TIMELINEINDEX_BENCHMARKTABLES_H
+#define TIMELINEINDEX_BENCHMARKTABLES_H
+
+// size of the generated tables, shared by the benchmarks and the server
+#define TEMPORAL_TABLE_SIZE 3'40'00
+#define DISTINCT_VALUES 100'000ull
+#define LIFETIME 10000 // determines how long a tuple lives, implicitly also determines the number of tuples that are still active
+#define NUMBER_OF_VERSIONS 2'20'00
+#define SNAPSHOT_CACHE_BUDGET (1ull << 30)
+
+/**
+ * @brief Returns a random lifespan of up to LIFETIME versions, rows living past the last version are never deleted
+ */
+LifeSpan generate_life_span();
+
+/**
+ * @brief Fills the table with TEMPORAL_TABLE_SIZE rows of one random value, seed std::rand for other tables
+ */
+void init_random_temporal_table(TemporalTable& table);
+
+#endif //TIMELINEINDEX_BENCHMARKTABLES_H
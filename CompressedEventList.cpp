@@ -0,0 +1,80 @@
+#include "CompressedEventList.h"
+#include <algorithm>
+#include <bit>
+
+
+void CompressedEventList::append_block(std::span<const Event> events) {
+    std::vector<Event> sorted(events.begin(), events.end());
+    // stable to keep the order of an insertion and deletion of the same row
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Event& a, const Event& b) {return a.row_id < b.row_id;});
+
+    row_id_type max_delta = 0;
+    for(uint64_t i = 1; i < sorted.size(); ++i) {
+        max_delta = std::max(max_delta, sorted[i].row_id - sorted[i - 1].row_id);
+    }
+    uint8_t width = std::bit_width(max_delta);
+
+    bases.push_back(sorted.empty() ? 0 : sorted[0].row_id);
+    bit_offsets.push_back(used_bits);
+    bit_widths.push_back(width);
+
+    deltas.resize((used_bits + sorted.size() * width) / 64 + 2, 0);
+    deletions.resize((event_number + sorted.size()) / 64 + 1, 0);
+
+    for(uint64_t i = 0; i < sorted.size(); ++i) {
+        uint64_t delta = i == 0 ? 0 : sorted[i].row_id - sorted[i - 1].row_id;
+        uint64_t word = used_bits / 64;
+        uint64_t shift = used_bits % 64;
+        deltas[word] |= delta << shift;
+        if(shift + width > 64) deltas[word + 1] |= delta >> (64 - shift);
+        used_bits += width;
+
+        if(sorted[i].type == EventType::DELETE) {
+            deletions[event_number / 64] |= 1ull << (event_number % 64);
+        }
+        ++event_number;
+    }
+}
+
+void CompressedEventList::decode_block(uint64_t block, uint64_t first_event, event_offset count, std::vector<Event>& result) const {
+    uint64_t width = bit_widths[block];
+    uint64_t mask = width == 0 ? 0 : ~0ull >> (64 - width);
+    uint64_t bit_offset = bit_offsets[block];
+
+    uint64_t old_size = result.size();
+    result.resize(old_size + count);
+    Event* decoded = result.data() + old_size;
+
+    // first pass unpacks the deltas, it is free of branches and dependencies between iterations. It is not vectorized,
+    // the loads of deltas[word] are gathered and the deltas are stored into the strided events
+    for(event_offset i = 0; i < count; ++i) {
+        uint64_t position = bit_offset + i * width;
+        uint64_t word = position / 64;
+        uint64_t shift = position % 64;
+        // the second shift avoids shifting by 64 if the delta does not cross a word boundary
+        uint64_t value = (deltas[word] >> shift) | ((deltas[word + 1] << 1) << (63 - shift));
+        decoded[i].row_id = value & mask;
+    }
+
+    // second pass restores the row ids and event types
+    row_id_type row_id = bases[block];
+    for(event_offset i = 0; i < count; ++i) {
+        row_id += decoded[i].row_id;
+        uint64_t event = first_event + i;
+        bool is_deletion = (deletions[event / 64] >> (event % 64)) & 1;
+        decoded[i] = Event(row_id, NO_ROW, is_deletion ? EventType::DELETE : EventType::INSERT);
+    }
+}
+
+void CompressedEventList::shrink_to_fit() {
+    deltas.shrink_to_fit();
+    deletions.shrink_to_fit();
+    bases.shrink_to_fit();
+    bit_offsets.shrink_to_fit();
+    bit_widths.shrink_to_fit();
+}
+
+uint64_t CompressedEventList::memory_usage() const {
+    return deltas.capacity() * sizeof(uint64_t) + deletions.capacity() * sizeof(uint64_t) + bases.capacity() * sizeof(row_id_type)
+           + bit_offsets.capacity() * sizeof(uint64_t) + bit_widths.capacity() * sizeof(uint8_t);
+}
@@ -0,0 +1,52 @@
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "EventList.h"
+
+#ifndef TIMELINEINDEX_COMPRESSEDEVENTLIST_H
+#define TIMELINEINDEX_COMPRESSEDEVENTLIST_H
+
+/**
+ * @brief CompressedEventList class
+ * @details Compressed alternative to the EventList, holding one block of events per version.
+ * Inside a block the events are sorted by row id, the row ids are delta encoded and bit packed with the
+ * width of the largest delta (frame of reference). Whether an event is a deletion is kept in a separate bitmap.
+ * Only events of a single table can be stored, row_id_second is not kept.
+ */
+class CompressedEventList {
+    // bit packed deltas of all blocks, padded by one word so decoding can always read two words
+    std::vector<uint64_t> deltas{0};
+    // bit i is set if event i is a deletion
+    std::vector<uint64_t> deletions;
+
+    // per block: first row id, position of the first delta in bits and width of the deltas
+    std::vector<row_id_type> bases;
+    std::vector<uint64_t> bit_offsets;
+    std::vector<uint8_t> bit_widths;
+
+    uint64_t event_number = 0;
+    uint64_t used_bits = 0;
+
+public:
+    CompressedEventList() = default;
+
+    /**
+     * @brief Appends the events of the next version as a new block
+     * @param events
+     */
+    void append_block(std::span<const Event> events);
+
+    /**
+     * @brief Decodes a block and appends its events to result
+     * @param block index of the block, i.e. the version relative to the first block
+     * @param first_event index of the first event of the block
+     * @param count number of events in the block
+     * @param result
+     */
+    void decode_block(uint64_t block, uint64_t first_event, event_offset count, std::vector<Event>& result) const;
+
+    void shrink_to_fit();
+    uint64_t memory_usage() const;
+};
+
+#endif //TIMELINEINDEX_COMPRESSEDEVENTLIST_H
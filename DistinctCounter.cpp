@@ -0,0 +1,80 @@
+#include "DistinctCounter.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+// values with a larger range are counted in the hashmap
+#define DENSE_RANGE_FACTOR 4
+#define DENSE_MIN_RANGE (1ull << 16)
+
+
+ExactDistinctCounter::ExactDistinctCounter(uint64_t min_value, uint64_t max_value, uint64_t expected_values) : min_value(min_value) {
+    // the difference instead of the range, which wraps to 0 for the full range of uint64_t
+    dense = max_value >= min_value && max_value - min_value < std::max<uint64_t>(DENSE_MIN_RANGE, expected_values * DENSE_RANGE_FACTOR);
+    if(dense) {
+        dense_counts.assign(max_value - min_value + 1, 0);
+    } else {
+        sparse_counts.reserve(expected_values);
+    }
+}
+
+uint64_t mix_bits(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ull;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return value;
+}
+
+ApproximateDistinctCounter::ApproximateDistinctCounter(uint8_t precision) : precision(precision), max_rank(64 - precision + 1) {
+    if(precision < 4 || precision > 18) throw std::invalid_argument("Precision must be between 4 and 18");
+    uint64_t register_amount = 1ull << precision;
+    ranks.assign(register_amount * (max_rank + 1), 0);
+    registers.assign(register_amount, 0);
+    harmonic_sum = register_amount;
+    empty_registers = register_amount;
+}
+
+void ApproximateDistinctCounter::set_register(uint64_t index, uint8_t rank) {
+    harmonic_sum += std::ldexp(1.0, -rank) - std::ldexp(1.0, -registers[index]);
+    empty_registers += (rank == 0) - (registers[index] == 0);
+    registers[index] = rank;
+}
+
+void ApproximateDistinctCounter::insert(uint64_t value) {
+    uint64_t hash = mix_bits(value);
+    uint64_t index = hash >> (64 - precision);
+    // position of the first set bit in the remaining bits, the padding bit limits it to max_rank
+    uint8_t rank = std::countl_zero((hash << precision) | (1ull << (precision - 1))) + 1;
+
+    ++ranks[index * (max_rank + 1) + rank];
+    if(rank > registers[index]) set_register(index, rank);
+}
+
+void ApproximateDistinctCounter::remove(uint64_t value) {
+    uint64_t hash = mix_bits(value);
+    uint64_t index = hash >> (64 - precision);
+    uint8_t rank = std::countl_zero((hash << precision) | (1ull << (precision - 1))) + 1;
+
+    uint32_t* counts = ranks.data() + index * (max_rank + 1);
+    if(--counts[rank] == 0 && rank == registers[index]) {
+        // the highest rank is gone, fall back to the next lower rank that is still counted
+        uint8_t new_rank = rank;
+        while(new_rank > 0 && counts[new_rank] == 0) --new_rank;
+        set_register(index, new_rank);
+    }
+}
+
+uint64_t ApproximateDistinctCounter::count() const {
+    double register_amount = registers.size();
+    double alpha = 0.7213 / (1 + 1.079 / register_amount);
+    double estimate = alpha * register_amount * register_amount / harmonic_sum;
+
+    // linear counting is more precise for small cardinalities
+    if(estimate <= 2.5 * register_amount && empty_registers > 0) {
+        estimate = register_amount * std::log(register_amount / empty_registers);
+    }
+    return std::llround(estimate);
+}
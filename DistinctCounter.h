@@ -0,0 +1,83 @@
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#ifndef TIMELINEINDEX_DISTINCTCOUNTER_H
+#define TIMELINEINDEX_DISTINCTCOUNTER_H
+
+/**
+ * @brief Hash of a 64 bit value, similar values end up in unrelated hashes (splitmix64 finalizer)
+ */
+uint64_t mix_bits(uint64_t value);
+
+/**
+ * @brief ExactDistinctCounter class
+ * @details Counts the distinct values of a multiset that values are inserted into and removed from.
+ * Every value has a reference count, held in a dense array if the range of the values is small enough
+ * (e.g. dictionary encoded values) and in a hashmap otherwise.
+ */
+class ExactDistinctCounter {
+    uint64_t min_value;
+    std::vector<uint32_t> dense_counts;
+    std::unordered_map<uint64_t, uint32_t> sparse_counts;
+    bool dense;
+    uint64_t distinct = 0;
+
+public:
+    /**
+     * @param min_value smallest value that will be inserted
+     * @param max_value largest value that will be inserted
+     * @param expected_values number of values expected to be alive at the same time, decides between dense and sparse
+     */
+    ExactDistinctCounter(uint64_t min_value, uint64_t max_value, uint64_t expected_values);
+
+    void insert(uint64_t value) {
+        uint32_t& count = dense ? dense_counts[value - min_value] : sparse_counts[value];
+        distinct += count == 0;
+        ++count;
+    }
+
+    void remove(uint64_t value) {
+        if(dense) {
+            distinct -= --dense_counts[value - min_value] == 0;
+            return;
+        }
+        auto it = sparse_counts.find(value);
+        if(--it->second == 0) {
+            sparse_counts.erase(it);
+            --distinct;
+        }
+    }
+
+    uint64_t count() const {
+        return distinct;
+    }
+};
+
+/**
+ * @brief ApproximateDistinctCounter class
+ * @details HyperLogLog that supports removals. Instead of the highest rank every register keeps how many
+ * values with every rank it has seen, so the highest rank can be restored when values are removed.
+ * The memory only depends on the precision, with 2^precision registers the standard error is about 1.04 / sqrt(2^precision).
+ */
+class ApproximateDistinctCounter {
+    uint8_t precision;
+    uint8_t max_rank;
+    // ranks[register * (max_rank + 1) + rank] counts the values with this rank in the register
+    std::vector<uint32_t> ranks;
+    std::vector<uint8_t> registers;
+    // sum of 2^-register over all registers and number of empty registers, maintained on every change
+    double harmonic_sum;
+    uint64_t empty_registers;
+
+    void set_register(uint64_t index, uint8_t rank);
+
+public:
+    explicit ApproximateDistinctCounter(uint8_t precision = 12);
+
+    void insert(uint64_t value);
+    void remove(uint64_t value);
+    uint64_t count() const;
+};
+
+#endif //TIMELINEINDEX_DISTINCTCOUNTER_H
@@ -0,0 +1,66 @@
+#include <cstdint>
+#include <new>
+#include <vector>
+#include "IndexTypes.h"
+
+#ifndef TIMELINEINDEX_EVENTBATCH_H
+#define TIMELINEINDEX_EVENTBATCH_H
+
+/**
+ * @brief Allocator for buffers aligned to 64 bytes, the alignment Arrow recommends for its buffers
+ */
+template<typename T>
+struct AlignedAllocator {
+    typedef T value_type;
+    static constexpr std::align_val_t alignment{64};
+
+    AlignedAllocator() = default;
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), alignment));
+    }
+
+    void deallocate(T* pointer, std::size_t) {
+        ::operator delete(pointer, alignment);
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U>&) const {return true;}
+};
+
+template<typename T>
+using AlignedBuffer = std::vector<T, AlignedAllocator<T>>;
+
+/**
+ * @brief Record batch of events in columnar layout
+ * @details every column is one contiguous, 64 byte aligned buffer of length values without nulls, so it can be handed
+ * to Arrow as a primitive array without copying. types holds 0 for insertions and 1 for deletions,
+ * columns[i] the values of the i-th projected column of the row of every event.
+ */
+struct EventBatch {
+    uint64_t length = 0;
+    AlignedBuffer<version> versions;
+    AlignedBuffer<row_id_type> row_ids;
+    AlignedBuffer<uint8_t> types;
+    std::vector<AlignedBuffer<uint64_t>> columns;
+
+    void clear() {
+        length = 0;
+        versions.clear();
+        row_ids.clear();
+        types.clear();
+        for(auto& column : columns) column.clear();
+    }
+};
+
+/**
+ * @brief Position inside the event stream, the event with the given index among the events of a version
+ */
+struct ExportPosition {
+    version version_number;
+    uint64_t event;
+};
+
+#endif //TIMELINEINDEX_EVENTBATCH_H
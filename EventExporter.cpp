@@ -0,0 +1,87 @@
+#include "EventExporter.h"
+#include <stdexcept>
+
+
+EventExporter::EventExporter(const TimelineIndex& index, version start_version, version end_version, std::vector<uint16_t> projection,
+                             uint64_t batch_size, uint64_t max_batches)
+    : index(index), projection(std::move(projection)), batch_size(batch_size), max_batches(max_batches), end_version(end_version) {
+    if(batch_size == 0 || max_batches == 0) throw std::invalid_argument("Batch size and number of batches must be larger than 0");
+    producer = std::thread(&EventExporter::produce, this, ExportPosition{start_version, 0});
+}
+
+EventExporter::~EventExporter() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    slot_free.notify_all();
+    producer.join();
+}
+
+void EventExporter::produce(ExportPosition position) {
+    while(position.version_number < end_version) {
+        EventBatch batch;
+        {
+            std::unique_lock lock(mutex);
+            slot_free.wait(lock, [&] {return stopping || batches_in_use < max_batches;});
+            if(stopping) return;
+            ++batches_in_use;
+            if(!free_batches.empty()) {
+                batch = std::move(free_batches.back());
+                free_batches.pop_back();
+            }
+        }
+
+        batch.clear();
+        try {
+            position = index.export_events(position, end_version, projection, batch_size, batch);
+        } catch(...) {
+            std::lock_guard lock(mutex);
+            error = std::current_exception();
+            --batches_in_use;
+            break;
+        }
+
+        std::lock_guard lock(mutex);
+        if(batch.length == 0) {
+            // nothing left, e.g. the end version is behind the latest version
+            --batches_in_use;
+            break;
+        }
+        full_batches.push_back(std::move(batch));
+        batch_ready.notify_one();
+    }
+
+    std::lock_guard lock(mutex);
+    finished = true;
+    batch_ready.notify_all();
+}
+
+std::optional<EventBatch> EventExporter::next() {
+    std::unique_lock lock(mutex);
+    batch_ready.wait(lock, [&] {return finished || !full_batches.empty();});
+    if(full_batches.empty()) {
+        if(error) std::rethrow_exception(error);
+        return std::nullopt;
+    }
+    auto batch = std::move(full_batches.front());
+    full_batches.pop_front();
+    return batch;
+}
+
+void EventExporter::recycle(EventBatch&& batch) {
+    {
+        std::lock_guard lock(mutex);
+        free_batches.push_back(std::move(batch));
+        --batches_in_use;
+    }
+    slot_free.notify_one();
+}
+
+void EventExporter::release() {
+    {
+        std::lock_guard lock(mutex);
+        --batches_in_use;
+    }
+    slot_free.notify_one();
+}
@@ -0,0 +1,72 @@
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "TimelineIndex.h"
+
+#ifndef TIMELINEINDEX_EVENTEXPORTER_H
+#define TIMELINEINDEX_EVENTEXPORTER_H
+
+/**
+ * @brief EventExporter class
+ * @details Streams the events of a version range as fixed size columnar EventBatches, see EventBatch.
+ * A background thread fills the batches while the consumer processes earlier ones. At most max_batches batches exist
+ * at the same time, the producer waits when all of them are full (backpressure), so the memory stays bounded
+ * independent of the length of the range. Consumers hand processed batches back with recycle to reuse their buffers.
+ */
+class EventExporter {
+    const TimelineIndex& index;
+    const std::vector<uint16_t> projection;
+    const uint64_t batch_size;
+    const uint64_t max_batches;
+    const version end_version;
+
+    std::mutex mutex;
+    std::condition_variable batch_ready;
+    std::condition_variable slot_free;
+    std::deque<EventBatch> full_batches;
+    std::vector<EventBatch> free_batches;
+    // batches handed out or queued
+    uint64_t batches_in_use = 0;
+    bool finished = false;
+    bool stopping = false;
+    std::exception_ptr error;
+
+    std::thread producer;
+
+    void produce(ExportPosition position);
+
+public:
+    /**
+     * @param index
+     * @param start_version first exported version
+     * @param end_version first version that is not exported
+     * @param projection columns whose values are exported with every event
+     * @param batch_size number of events per batch, the last batch may be shorter
+     * @param max_batches number of batches that may exist at the same time, at least 1
+     */
+    EventExporter(const TimelineIndex& index, version start_version, version end_version, std::vector<uint16_t> projection,
+                  uint64_t batch_size = 1 << 16, uint64_t max_batches = 4);
+    ~EventExporter();
+
+    /**
+     * @brief Returns the next batch in event order, empty once all events are exported
+     * @details blocks until the batch is filled, rethrows errors of the export
+     */
+    std::optional<EventBatch> next();
+
+    /**
+     * @brief Hands a batch returned by next back, its buffers are reused for later batches
+     * @details batches that are not recycled still count against max_batches until the consumer releases them with release
+     */
+    void recycle(EventBatch&& batch);
+
+    /**
+     * @brief Gives up the slot of a batch returned by next that the consumer keeps
+     */
+    void release();
+};
+
+#endif //TIMELINEINDEX_EVENTEXPORTER_H
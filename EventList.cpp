@@ -3,18 +3,18 @@
 //
 #include "EventList.h"
 
-EventList::EventList(uint32_t size) : events(size) {}
+EventList::EventList(event_offset size) : events(size) {}
 
 void EventList::append(Event event) {
     events.push_back(event);
 }
 
-void EventList::insert(Event event, int index) {
+void EventList::insert(Event event, event_offset index) {
     events[index] = event;
 }
 
-std::span<Event> EventList::get_events(uint32_t start_version, uint32_t end_version) {
-    std::span<Event> result(events.begin() + start_version, events.begin() + end_version);
+std::span<const Event> EventList::get_events(event_offset start_index, event_offset end_index) const {
+    std::span<const Event> result(events.begin() + start_index, events.begin() + end_index);
     return result;
 }
 
@@ -23,3 +23,7 @@ void EventList::append_list(std::vector<Event> appending_events) {
     this->events.insert(this->events.end(), appending_events.begin(), appending_events.end());
 }
 
+
+uint64_t EventList::memory_usage() const {
+    return events.capacity() * sizeof(Event);
+}
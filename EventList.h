@@ -7,6 +7,7 @@
 #include <vector>
 #include <span>
 #include <cstdint>
+#include "IndexTypes.h"
 
 #ifndef TIMELINEINDEX_EVENTLIST_H
 #define TIMELINEINDEX_EVENTLIST_H
@@ -18,12 +19,12 @@ enum EventType {
 
 
 struct Event {
-    uint32_t row_id;
-    uint32_t row_id_second = -1;
+    row_id_type row_id;
+    row_id_type row_id_second = NO_ROW;
     EventType type;
 
     // constructors as clang seems to not like implicit constructors
-    Event(uint32_t row_id, uint32_t row_id_second, EventType type) : row_id(row_id), row_id_second(row_id_second), type(type) {}
+    Event(row_id_type row_id, row_id_type row_id_second, EventType type) : row_id(row_id), row_id_second(row_id_second), type(type) {}
     Event() = default;
 };
 
@@ -38,11 +39,12 @@ class EventList {
 
 public:
     EventList() = default;
-    explicit EventList(uint32_t size);
+    explicit EventList(event_offset size);
     void append(Event event);
-    std::span<Event> get_events(uint32_t start_version, uint32_t end_version);
+    std::span<const Event> get_events(event_offset start_index, event_offset end_index) const;
     void append_list(std::vector<Event> events);
-    void insert(Event event, int index);
+    void insert(Event event, event_offset index);
+    uint64_t memory_usage() const;
 
 };
 
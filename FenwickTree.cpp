@@ -0,0 +1,34 @@
+#include "FenwickTree.h"
+#include <bit>
+
+
+FenwickTree::FenwickTree(uint64_t size) : tree(size + 1, 0) {
+    highest_power = size == 0 ? 0 : std::bit_floor(size);
+}
+
+void FenwickTree::insert(uint64_t position) {
+    for(uint64_t i = position + 1; i < tree.size(); i += i & -i) {
+        ++tree[i];
+    }
+    ++count;
+}
+
+void FenwickTree::remove(uint64_t position) {
+    for(uint64_t i = position + 1; i < tree.size(); i += i & -i) {
+        --tree[i];
+    }
+    --count;
+}
+
+uint64_t FenwickTree::find_rank(uint64_t rank) const {
+    // descend from the largest power of two, keeping the prefix below the rank
+    uint64_t position = 0;
+    for(uint64_t step = highest_power; step > 0; step >>= 1) {
+        if(position + step < tree.size() && tree[position + step] < rank) {
+            position += step;
+            rank -= tree[position];
+        }
+    }
+    // position is the 1-based index of the last prefix below the rank, i.e. the 0-based position of the rank
+    return position;
+}
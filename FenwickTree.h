@@ -0,0 +1,35 @@
+#include <cstdint>
+#include <vector>
+
+#ifndef TIMELINEINDEX_FENWICKTREE_H
+#define TIMELINEINDEX_FENWICKTREE_H
+
+/**
+ * @brief FenwickTree class
+ * @details Binary indexed tree counting how often every position in [0, size) is present.
+ * Supports adding and removing occurrences and finding the position of the k-th smallest occurrence in O(log size),
+ * which makes it an order statistics structure over dictionary codes.
+ */
+class FenwickTree {
+    // 1-based, tree[i] counts the occurrences of the positions (i - lowbit(i), i]
+    std::vector<uint32_t> tree;
+    uint64_t highest_power = 0;
+    uint64_t count = 0;
+
+public:
+    explicit FenwickTree(uint64_t size);
+
+    void insert(uint64_t position);
+    void remove(uint64_t position);
+
+    /**
+     * @brief Returns the position of the occurrence with the given rank, ranks start at 1 and must be <= total()
+     */
+    uint64_t find_rank(uint64_t rank) const;
+
+    uint64_t total() const {
+        return count;
+    }
+};
+
+#endif //TIMELINEINDEX_FENWICKTREE_H
@@ -0,0 +1,88 @@
+#include "IndexStatistics.h"
+#include <iomanip>
+
+
+void Histogram::print(std::ostream& out) const {
+    for(uint32_t i=0; i<buckets.size(); i++) {
+        if(buckets[i] == 0) continue;
+        uint64_t lower = i == 0 ? 0 : 1ull << (i - 1);
+        out << "    >= " << std::setw(10) << lower << ": " << buckets[i] << std::endl;
+    }
+}
+
+IndexStatistics::IndexStatistics(const IndexStatistics& other) {
+    *this = other;
+}
+
+IndexStatistics& IndexStatistics::operator=(const IndexStatistics& other) {
+    if(this == &other) return *this;
+    std::scoped_lock lock(mutex, other.mutex);
+
+    time_travel_calls = other.time_travel_calls;
+    forward_replays = other.forward_replays;
+    backward_replays = other.backward_replays;
+    time_travel_events = other.time_travel_events;
+    time_travel_time = other.time_travel_time;
+    aggregate_threads = other.aggregate_threads;
+    aggregate_events = other.aggregate_events;
+    max_set_rebuilds = other.max_set_rebuilds;
+    checkpoint_hits = other.checkpoint_hits;
+    replay_distance = other.replay_distance;
+    thread_time = other.thread_time;
+    threads = other.threads;
+
+    return *this;
+}
+
+void IndexStatistics::record_time_travel(const TimeTravelRecord& record) {
+    std::lock_guard lock(mutex);
+    ++time_travel_calls;
+    if(record.forward) {
+        ++forward_replays;
+        replay_distance.add(record.query_version - record.checkpoint_version);
+    } else {
+        ++backward_replays;
+        replay_distance.add(record.checkpoint_version - record.query_version);
+    }
+    time_travel_events += record.events_applied;
+    time_travel_time += record.duration;
+    ++checkpoint_hits[record.checkpoint_version];
+}
+
+void IndexStatistics::record_thread(const ThreadRecord& record) {
+    std::lock_guard lock(mutex);
+    ++aggregate_threads;
+    aggregate_events += record.events_applied;
+    max_set_rebuilds += record.max_set_rebuilds;
+    thread_time.add(record.duration);
+    threads.push_back(record);
+}
+
+void IndexStatistics::reset() {
+    *this = IndexStatistics();
+}
+
+void IndexStatistics::print(std::ostream& out) const {
+    std::lock_guard lock(mutex);
+    out << "Time travels:        " << time_travel_calls << " (" << forward_replays << " forward, " << backward_replays << " backward)" << std::endl;
+    out << "Replayed events:     " << time_travel_events << std::endl;
+    out << "Time travel time:    " << time_travel_time << std::endl;
+    out << "Aggregate threads:   " << aggregate_threads << std::endl;
+    out << "Aggregate events:    " << aggregate_events << std::endl;
+    out << "Max set rebuilds:    " << max_set_rebuilds << std::endl;
+
+    out << "Checkpoint hits:" << std::endl;
+    for(auto [checkpoint_version, hits] : checkpoint_hits) {
+        out << "    " << std::setw(10) << checkpoint_version << ": " << hits << std::endl;
+    }
+    out << "Replay distance:" << std::endl;
+    replay_distance.print(out);
+    out << "Thread time:" << std::endl;
+    thread_time.print(out);
+
+    out << "Threads:" << std::endl;
+    for(auto& thread : threads) {
+        out << "    " << thread.query << " [" << thread.starting_version << ", " << thread.ending_version << "): "
+            << thread.events_applied << " events, " << thread.max_set_rebuilds << " rebuilds, " << thread.duration << std::endl;
+    }
+}
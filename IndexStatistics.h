@@ -0,0 +1,90 @@
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include "IndexTypes.h"
+
+#ifndef TIMELINEINDEX_INDEXSTATISTICS_H
+#define TIMELINEINDEX_INDEXSTATISTICS_H
+
+/**
+ * @brief Histogram with power of two buckets
+ * @details bucket i counts the values in [2^(i-1), 2^i), bucket 0 counts zeros
+ */
+struct Histogram {
+    std::array<uint64_t, 65> buckets{};
+
+    void add(uint64_t value) {
+        ++buckets[std::bit_width(value)];
+    }
+
+    void print(std::ostream& out) const;
+};
+
+/**
+ * @brief Information about a single time travel
+ * @details forward is false if the events were replayed backwards from a later checkpoint
+ */
+struct TimeTravelRecord {
+    version query_version;
+    version checkpoint_version;
+    bool forward;
+    uint64_t events_applied;
+    uint64_t duration;
+};
+
+/**
+ * @brief Information about a single thread of temporal_sum or temporal_max
+ */
+struct ThreadRecord {
+    const char* query;
+    version starting_version;
+    version ending_version;
+    uint64_t events_applied;
+    uint64_t max_set_rebuilds;
+    uint64_t duration;
+};
+
+/**
+ * @brief IndexStatistics class
+ * @details Counters and timings (in microseconds) collected by the TimelineIndex while answering queries.
+ * Values are only recorded if the index is compiled with STATISTICS defined, otherwise everything stays zero.
+ * Recording happens once per time travel and once per thread, never per event, so a plain mutex is sufficient.
+ */
+class IndexStatistics {
+    mutable std::mutex mutex;
+
+public:
+    uint64_t time_travel_calls = 0;
+    uint64_t forward_replays = 0;
+    uint64_t backward_replays = 0;
+    uint64_t time_travel_events = 0;
+    uint64_t time_travel_time = 0;
+
+    uint64_t aggregate_threads = 0;
+    uint64_t aggregate_events = 0;
+    uint64_t max_set_rebuilds = 0;
+
+    // how often each checkpoint was used as the starting point of a time travel
+    std::map<version, uint64_t> checkpoint_hits;
+    // distance in versions between the queried version and the used checkpoint
+    Histogram replay_distance;
+    // runtime of the threads spawned by the aggregates
+    Histogram thread_time;
+    std::vector<ThreadRecord> threads;
+
+    IndexStatistics() = default;
+    IndexStatistics(const IndexStatistics& other);
+    IndexStatistics& operator=(const IndexStatistics& other);
+
+    void record_time_travel(const TimeTravelRecord& record);
+    void record_thread(const ThreadRecord& record);
+    void reset();
+
+    void print(std::ostream& out) const;
+};
+
+#endif //TIMELINEINDEX_INDEXSTATISTICS_H
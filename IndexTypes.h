@@ -0,0 +1,26 @@
+#include <cstdint>
+#include <limits>
+
+#ifndef TIMELINEINDEX_INDEXTYPES_H
+#define TIMELINEINDEX_INDEXTYPES_H
+
+/**
+ * @brief Widths of row ids, versions and event offsets
+ * @details 32 bit by default, which keeps an event at 12 bytes but caps an index at 4 billion rows, versions and events.
+ * Building with WIDE_IDS (the TimelineIndexWide target) switches all of them to 64 bit. The checkpoints of a
+ * TimelineIndex cap its rows further, see CHECKPOINT_BITS.
+ */
+#ifdef WIDE_IDS
+typedef uint64_t row_id_type;
+typedef uint64_t version;
+typedef uint64_t event_offset;
+#else
+typedef uint32_t row_id_type;
+typedef uint32_t version;
+typedef uint32_t event_offset;
+#endif
+
+// row_id_second of events that do not come from a join
+inline constexpr row_id_type NO_ROW = std::numeric_limits<row_id_type>::max();
+
+#endif //TIMELINEINDEX_INDEXTYPES_H
@@ -0,0 +1,62 @@
+#include "KeyIndex.h"
+#include <algorithm>
+#include <numeric>
+
+
+KeyIndex::KeyIndex(const TemporalTable& given_table, uint16_t index) : table(given_table), index(index), row_ids(given_table.get_table_size()) {
+    std::iota(row_ids.begin(), row_ids.end(), 0);
+    // reclaimed rows have no key anymore
+    std::erase_if(row_ids, [&](row_id_type row_id) {return table.row(row_id).empty();});
+    std::sort(row_ids.begin(), row_ids.end(), [&](row_id_type a, row_id_type b) {
+        auto key_a = table.row(a)[index];
+        auto key_b = table.row(b)[index];
+        if(key_a != key_b) return key_a < key_b;
+        auto start_a = table.tuples[a].second.start;
+        auto start_b = table.tuples[b].second.start;
+        if(start_a != start_b) return start_a < start_b;
+        return a < b;
+    });
+
+    row_id_type begin = 0;
+    for(row_id_type i = 1; i <= row_ids.size(); ++i) {
+        if(i == row_ids.size() || table.row(row_ids[i])[index] != table.row(row_ids[begin])[index]) {
+            ranges.emplace(table.row(row_ids[begin])[index], std::pair{begin, i});
+            begin = i;
+        }
+    }
+}
+
+std::span<const row_id_type> KeyIndex::history(uint64_t key) const {
+    auto it = ranges.find(key);
+    if(it == ranges.end()) return {};
+    auto [begin, end] = it->second;
+    return {row_ids.data() + begin, row_ids.data() + end};
+}
+
+std::vector<row_id_type> KeyIndex::rows_at(uint64_t key, version query_version) const {
+    std::vector<row_id_type> result;
+    auto rows = history(key);
+
+    // only rows that started before or at the query version can be alive
+    auto last = std::upper_bound(rows.begin(), rows.end(), query_version, [&](version query, row_id_type row_id) {
+        return query < table.tuples[row_id].second.start;
+    });
+
+    for(auto it = rows.begin(); it != last; ++it) {
+        auto& lifespan = table.tuples[*it].second;
+        if(!lifespan.end.has_value() || lifespan.end.value() > query_version) {
+            result.push_back(*it);
+        }
+    }
+
+    return result;
+}
+
+std::vector<Tuple> KeyIndex::time_travel(uint64_t key, version query_version) const {
+    std::vector<Tuple> result;
+    for(auto row_id : rows_at(key, query_version)) {
+        auto values = table.row(row_id);
+        result.emplace_back(values.begin(), values.end());
+    }
+    return result;
+}
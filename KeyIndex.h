@@ -0,0 +1,53 @@
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include "TemporalTable.h"
+
+#ifndef TIMELINEINDEX_KEYINDEX_H
+#define TIMELINEINDEX_KEYINDEX_H
+
+/**
+ * @brief KeyIndex class
+ * @details Secondary index from the value of a key column to all rows with this value.
+ * The rows of a key are stored contiguously and ordered by the start of their lifespan,
+ * so the history of a key or its state at a version is found without touching the event stream.
+ * Rows added to the table after construction are not indexed.
+ */
+class KeyIndex {
+    const TemporalTable& table;
+    uint16_t index;
+
+    // row ids grouped by key, ordered by LifeSpan::start inside each group
+    std::vector<row_id_type> row_ids;
+    // key -> [begin, end) inside row_ids
+    std::unordered_map<uint64_t, std::pair<row_id_type, row_id_type>> ranges;
+
+public:
+    KeyIndex(const TemporalTable& table, uint16_t index);
+
+    /**
+     * @brief Returns all row ids that ever had the given key, ordered by their start version
+     * @param key
+     * @return
+     */
+    std::span<const row_id_type> history(uint64_t key) const;
+
+    /**
+     * @brief Returns the row ids with the given key that are alive at the given version
+     * @param key
+     * @param query_version
+     * @return
+     */
+    std::vector<row_id_type> rows_at(uint64_t key, version query_version) const;
+
+    /**
+     * @brief Returns the tuples with the given key that are alive at the given version
+     * @param key
+     * @param query_version
+     * @return
+     */
+    std::vector<Tuple> time_travel(uint64_t key, version query_version) const;
+};
+
+#endif //TIMELINEINDEX_KEYINDEX_H
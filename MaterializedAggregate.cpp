@@ -0,0 +1,75 @@
+#include "MaterializedAggregate.h"
+#include <algorithm>
+#include <stdexcept>
+
+MaterializedAggregate::MaterializedAggregate(uint16_t index, std::vector<uint64_t> sums, std::vector<uint64_t> counts,
+                                             std::vector<uint64_t> maxima, const std::vector<uint64_t>& live_values)
+    : index(index), sums(std::move(sums)), counts(std::move(counts)), maxima(std::move(maxima)) {
+    if(this->sums.size() != this->counts.size() || this->sums.size() != this->maxima.size()) {
+        throw std::invalid_argument("Series have different lengths");
+    }
+    for(auto value : live_values) {
+        ++this->live_values[value];
+    }
+}
+
+uint16_t MaterializedAggregate::get_index() const {
+    return index;
+}
+
+version MaterializedAggregate::get_base_version() const {
+    return base_version;
+}
+
+void MaterializedAggregate::drop_before(version new_base_version) {
+    if(new_base_version <= base_version) return;
+    uint64_t dropped = std::min<uint64_t>(new_base_version - base_version, sums.size());
+    sums.erase(sums.begin(), sums.begin() + dropped);
+    counts.erase(counts.begin(), counts.begin() + dropped);
+    maxima.erase(maxima.begin(), maxima.begin() + dropped);
+    base_version = new_base_version;
+}
+
+void MaterializedAggregate::append(std::span<const Event> events, const TemporalTable& table) {
+    uint64_t sum = sums.empty() ? 0 : sums.back();
+    uint64_t count = counts.empty() ? 0 : counts.back();
+
+    for(auto& event : events) {
+        auto value = table.row(event.row_id)[index];
+        if(event.type == EventType::INSERT) {
+            sum += value;
+            ++count;
+            ++live_values[value];
+            continue;
+        }
+        sum -= value;
+        --count;
+        // like the replay kernels the events are trusted, deleting a row that is not alive leaves the maxima alone
+        auto live_value = live_values.find(value);
+        if(live_value != live_values.end() && --live_value->second == 0) live_values.erase(live_value);
+    }
+
+    sums.push_back(sum);
+    counts.push_back(count);
+    maxima.push_back(live_values.empty() ? 0 : live_values.rbegin()->first);
+}
+
+MaterializedValues MaterializedAggregate::get(version query_version) const {
+    if(query_version < base_version || query_version - base_version >= sums.size()) {
+        throw std::invalid_argument("Version does not exist");
+    }
+    uint64_t position = query_version - base_version;
+    return {sums[position], counts[position], maxima[position]};
+}
+
+const std::vector<uint64_t>& MaterializedAggregate::get_sums() const {
+    return sums;
+}
+
+const std::vector<uint64_t>& MaterializedAggregate::get_counts() const {
+    return counts;
+}
+
+const std::vector<uint64_t>& MaterializedAggregate::get_maxima() const {
+    return maxima;
+}
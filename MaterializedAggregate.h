@@ -0,0 +1,68 @@
+#include <cstdint>
+#include <map>
+#include <span>
+#include <vector>
+#include "EventList.h"
+#include "TemporalTable.h"
+
+#ifndef TIMELINEINDEX_MATERIALIZEDAGGREGATE_H
+#define TIMELINEINDEX_MATERIALIZEDAGGREGATE_H
+
+/**
+ * @brief Aggregates of one column at one version, max is 0 if no row is alive
+ */
+struct MaterializedValues {
+    uint64_t sum;
+    uint64_t count;
+    uint64_t max;
+};
+
+/**
+ * @brief MaterializedAggregate class
+ * @details Keeps the sum, count and max of a column for every retained version and extends them with every appended
+ * version. The values of the rows alive at the latest version are counted in an ordered map, so deleting the maximum
+ * finds the next one without replaying. Reading a version is a lookup in the series.
+ */
+class MaterializedAggregate {
+    uint16_t index;
+    // the series start at this version, older versions were dropped
+    version base_version = 0;
+    std::vector<uint64_t> sums;
+    std::vector<uint64_t> counts;
+    std::vector<uint64_t> maxima;
+    std::map<uint64_t, uint64_t> live_values;
+
+public:
+    /**
+     * @param index column of the aggregate
+     * @param sums, counts, maxima series of all versions so far, e.g. computed by TimelineIndex::temporal_aggregates
+     * @param live_values values of the rows alive at the latest version
+     */
+    MaterializedAggregate(uint16_t index, std::vector<uint64_t> sums, std::vector<uint64_t> counts,
+                          std::vector<uint64_t> maxima, const std::vector<uint64_t>& live_values);
+
+    uint16_t get_index() const;
+    version get_base_version() const;
+
+    /**
+     * @brief Applies the events of a new version on top of the latest version and stores its aggregates
+     * @details the cost only depends on the number of events, the rows of the events have to exist in the table
+     */
+    void append(std::span<const Event> events, const TemporalTable& table);
+
+    // removes the values of all versions before the given one
+    void drop_before(version new_base_version);
+
+    /**
+     * @brief Returns the aggregates of the given version
+     * @details throws std::invalid_argument if the version was dropped or does not exist
+     */
+    MaterializedValues get(version query_version) const;
+
+    // series of the retained versions, they start at the base version
+    const std::vector<uint64_t>& get_sums() const;
+    const std::vector<uint64_t>& get_counts() const;
+    const std::vector<uint64_t>& get_maxima() const;
+};
+
+#endif //TIMELINEINDEX_MATERIALIZEDAGGREGATE_H
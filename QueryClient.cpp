@@ -0,0 +1,108 @@
+#include "QueryClient.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+std::vector<uint64_t> QueryResponse::values() const {
+    std::vector<uint64_t> result(payload.size() / sizeof(uint64_t));
+    std::memcpy(result.data(), payload.data(), result.size() * sizeof(uint64_t));
+    return result;
+}
+
+std::vector<RollupBucket> QueryResponse::buckets() const {
+    std::vector<RollupBucket> result(payload.size() / sizeof(RollupBucket));
+    std::memcpy(result.data(), payload.data(), result.size() * sizeof(RollupBucket));
+    return result;
+}
+
+std::string QueryResponse::message() const {
+    return {payload.begin(), payload.end()};
+}
+
+namespace {
+
+int connect_socket(const std::string& socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(socket_path.size() >= sizeof(address.sun_path)) throw std::invalid_argument("Socket path is too long");
+    std::strcpy(address.sun_path, socket_path.c_str());
+
+    int result = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(result < 0) throw std::system_error(errno, std::generic_category(), "Creating the socket failed");
+    if(connect(result, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        int error = errno;
+        close(result);
+        throw std::system_error(error, std::generic_category(), "Connecting to the server failed");
+    }
+    return result;
+}
+
+}
+
+
+QueryClient::QueryClient(const std::string& socket_path) : socket(connect_socket(socket_path)), stream(socket) {}
+
+QueryClient::~QueryClient() {
+    close(socket);
+}
+
+uint32_t QueryClient::send(Opcode opcode, const void* payload, uint32_t payload_size) {
+    RequestHeader header{};
+    header.request_id = next_request_id++;
+    header.opcode = opcode;
+    header.payload_size = payload_size;
+    iovec parts[2] = {{&header, sizeof(header)}, {const_cast<void*>(payload), payload_size}};
+    stream.write(parts);
+    return header.request_id;
+}
+
+uint32_t QueryClient::send_time_travel(version query_version, const std::vector<uint16_t>& projection) {
+    std::vector<char> payload(sizeof(uint64_t) + projection.size() * sizeof(uint16_t));
+    uint64_t wire_version = query_version;
+    std::memcpy(payload.data(), &wire_version, sizeof(wire_version));
+    std::memcpy(payload.data() + sizeof(wire_version), projection.data(), projection.size() * sizeof(uint16_t));
+    return send(Opcode::TIME_TRAVEL, payload.data(), payload.size());
+}
+
+uint32_t QueryClient::send_aggregate(AggregateType type, uint16_t column) {
+    uint16_t payload[2] = {static_cast<uint16_t>(type), column};
+    return send(Opcode::AGGREGATE, payload, sizeof(payload));
+}
+
+uint32_t QueryClient::send_aggregate_rollup(AggregateType type, uint16_t column, version bucket_width) {
+    char payload[2 * sizeof(uint16_t) + sizeof(uint64_t)];
+    uint16_t fields[2] = {static_cast<uint16_t>(type), column};
+    uint64_t wire_width = bucket_width;
+    std::memcpy(payload, fields, sizeof(fields));
+    std::memcpy(payload + sizeof(fields), &wire_width, sizeof(wire_width));
+    return send(Opcode::AGGREGATE_ROLLUP, payload, sizeof(payload));
+}
+
+uint32_t QueryClient::send_diff(version from_version, version to_version) {
+    uint64_t payload[2] = {from_version, to_version};
+    return send(Opcode::DIFF, payload, sizeof(payload));
+}
+
+uint32_t QueryClient::send_append(const std::vector<Event>& events) {
+    std::vector<WireEvent> payload;
+    payload.reserve(events.size());
+    for(auto& event : events) {
+        payload.push_back(WireEvent{event.row_id, event.type == EventType::DELETE});
+    }
+    return send(Opcode::APPEND, payload.data(), payload.size() * sizeof(WireEvent));
+}
+
+QueryResponse QueryClient::receive() {
+    ResponseHeader header;
+    if(!stream.read(&header, sizeof(header))) throw std::system_error(ECONNRESET, std::generic_category(), "Server closed the connection");
+    QueryResponse response{header.request_id, header.status, std::vector<char>(header.payload_size)};
+    if(!stream.read(response.payload.data(), response.payload.size())) {
+        throw std::system_error(ECONNRESET, std::generic_category(), "Server closed the connection");
+    }
+    return response;
+}
@@ -0,0 +1,54 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "QueryProtocol.h"
+#include "TimelineIndex.h"
+
+#ifndef TIMELINEINDEX_QUERYCLIENT_H
+#define TIMELINEINDEX_QUERYCLIENT_H
+
+struct QueryResponse {
+    uint32_t request_id;
+    Status status;
+    std::vector<char> payload;
+
+    // payload as uint64_t values, e.g. the series of an aggregate
+    std::vector<uint64_t> values() const;
+    // payload as buckets of a rollup aggregate
+    std::vector<RollupBucket> buckets() const;
+    // payload of an ERROR response
+    std::string message() const;
+};
+
+/**
+ * @brief QueryClient class
+ * @details Connection to a QueryServer. The send functions only write the request and return its id,
+ * so several requests can be in flight at once. receive returns the responses in the order of the requests.
+ * Throws std::system_error if the connection fails.
+ */
+class QueryClient {
+    int socket;
+    SocketStream stream;
+    uint32_t next_request_id = 0;
+
+    uint32_t send(Opcode opcode, const void* payload, uint32_t payload_size);
+
+public:
+    explicit QueryClient(const std::string& socket_path);
+    ~QueryClient();
+    QueryClient(const QueryClient&) = delete;
+    QueryClient& operator=(const QueryClient&) = delete;
+
+    uint32_t send_time_travel(version query_version, const std::vector<uint16_t>& projection);
+    uint32_t send_aggregate(AggregateType type, uint16_t column);
+    uint32_t send_aggregate_rollup(AggregateType type, uint16_t column, version bucket_width);
+    uint32_t send_diff(version from_version, version to_version);
+    uint32_t send_append(const std::vector<Event>& events);
+
+    /**
+     * @brief Waits for the next response, throws std::system_error if the server closed the connection
+     */
+    QueryResponse receive();
+};
+
+#endif //TIMELINEINDEX_QUERYCLIENT_H
@@ -0,0 +1,133 @@
+#include "QueryExecutor.h"
+#include <algorithm>
+#include <exception>
+
+#define MAX_BATCH_SIZE 256
+
+
+QueryExecutor::QueryExecutor(const TimelineIndex& index, uint32_t worker_amount) : index(index) {
+    for(uint32_t i=0; i<worker_amount; i++) {
+        workers.emplace_back(&QueryExecutor::work, this);
+    }
+}
+
+QueryExecutor::~QueryExecutor() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    pending.notify_all();
+    for(auto& worker : workers) {
+        worker.join();
+    }
+}
+
+std::future<std::vector<Tuple>> QueryExecutor::submit_time_travel(version query_version) {
+    std::promise<std::vector<Tuple>> promise;
+    auto future = promise.get_future();
+    {
+        std::lock_guard lock(mutex);
+        time_travels.push_back(TimeTravelRequest{query_version, std::move(promise)});
+    }
+    pending.notify_one();
+    return future;
+}
+
+std::future<std::vector<uint64_t>> QueryExecutor::submit_aggregate(AggregateType type, uint16_t column) {
+    std::promise<std::vector<uint64_t>> promise;
+    auto future = promise.get_future();
+    {
+        std::lock_guard lock(mutex);
+        aggregates.push_back(AggregateRequest{type, column, std::move(promise)});
+    }
+    pending.notify_one();
+    return future;
+}
+
+void QueryExecutor::work() {
+    while(true) {
+        std::vector<TimeTravelRequest> time_travel_batch;
+        std::vector<AggregateRequest> aggregate_batch;
+
+        {
+            std::unique_lock lock(mutex);
+            pending.wait(lock, [&] {return stopping || !time_travels.empty() || !aggregates.empty();});
+            if(time_travels.empty() && aggregates.empty()) return;
+
+            if(!time_travels.empty()) {
+                while(!time_travels.empty() && time_travel_batch.size() < MAX_BATCH_SIZE) {
+                    time_travel_batch.push_back(std::move(time_travels.front()));
+                    time_travels.pop_front();
+                }
+            } else {
+                while(!aggregates.empty() && aggregate_batch.size() < MAX_BATCH_SIZE) {
+                    aggregate_batch.push_back(std::move(aggregates.front()));
+                    aggregates.pop_front();
+                }
+            }
+        }
+
+        if(!time_travel_batch.empty()) answer_time_travels(time_travel_batch);
+        if(!aggregate_batch.empty()) answer_aggregates(aggregate_batch);
+    }
+}
+
+void QueryExecutor::answer_time_travels(std::vector<TimeTravelRequest>& requests) {
+    std::vector<version> versions;
+    versions.reserve(requests.size());
+    for(auto& request : requests) {
+        versions.push_back(request.query_version);
+    }
+
+    try {
+        auto results = index.time_travel_batch(versions);
+        for(uint64_t i=0; i<requests.size(); i++) {
+            requests[i].result.set_value(std::move(results[i]));
+        }
+    } catch(...) {
+        // one invalid version fails the whole batch, answer one by one to only fail the invalid requests
+        for(auto& request : requests) {
+            try {
+                request.result.set_value(index.time_travel(request.query_version));
+            } catch(...) {
+                request.result.set_exception(std::current_exception());
+            }
+        }
+    }
+}
+
+void QueryExecutor::answer_aggregates(std::vector<AggregateRequest>& requests) {
+    // requests for the same aggregate share one series
+    std::vector<AggregateSpec> specs;
+    std::vector<uint64_t> positions;
+    for(auto& request : requests) {
+        auto it = std::find_if(specs.begin(), specs.end(), [&](const AggregateSpec& spec) {
+            return spec.type == request.type && spec.index == request.index;
+        });
+        positions.push_back(it - specs.begin());
+        if(it == specs.end()) specs.push_back(AggregateSpec{request.type, request.index});
+    }
+
+    try {
+        auto results = index.temporal_aggregates(specs);
+        for(uint64_t i=0; i<requests.size(); i++) {
+            requests[i].result.set_value(results[positions[i]]);
+        }
+    } catch(...) {
+        // one invalid aggregate fails the whole batch, compute every aggregate alone to only fail its requests
+        for(uint64_t i=0; i<specs.size(); i++) {
+            std::vector<uint64_t> series;
+            std::exception_ptr error;
+            try {
+                series = std::move(index.temporal_aggregates({specs[i]})[0]);
+            } catch(...) {
+                error = std::current_exception();
+            }
+            for(uint64_t j=0; j<requests.size(); j++) {
+                if(positions[j] != i) continue;
+                if(error) requests[j].result.set_exception(error);
+                else requests[j].result.set_value(series);
+            }
+        }
+    }
+}
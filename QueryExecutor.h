@@ -0,0 +1,53 @@
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "TimelineIndex.h"
+
+#ifndef TIMELINEINDEX_QUERYEXECUTOR_H
+#define TIMELINEINDEX_QUERYEXECUTOR_H
+
+struct TimeTravelRequest {
+    version query_version;
+    std::promise<std::vector<Tuple>> result;
+};
+
+struct AggregateRequest {
+    AggregateType type;
+    uint16_t index;
+    std::promise<std::vector<uint64_t>> result;
+};
+
+/**
+ * @brief QueryExecutor class
+ * @details Answers queries on a TimelineIndex asynchronously with a fixed number of worker threads.
+ * A worker takes all pending time travels at once and answers them with a single time_travel_batch,
+ * so requests for nearby versions share their replay. Pending aggregates are answered together by one
+ * temporal_aggregates call, identical aggregates are computed once.
+ * The destructor answers all pending requests before the workers stop.
+ */
+class QueryExecutor {
+    const TimelineIndex& index;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable pending;
+    std::deque<TimeTravelRequest> time_travels;
+    std::deque<AggregateRequest> aggregates;
+    bool stopping = false;
+
+    void work();
+    void answer_time_travels(std::vector<TimeTravelRequest>& requests);
+    void answer_aggregates(std::vector<AggregateRequest>& requests);
+
+public:
+    explicit QueryExecutor(const TimelineIndex& index, uint32_t worker_amount = 2);
+    ~QueryExecutor();
+
+    std::future<std::vector<Tuple>> submit_time_travel(version query_version);
+    std::future<std::vector<uint64_t>> submit_aggregate(AggregateType type, uint16_t column);
+};
+
+#endif //TIMELINEINDEX_QUERYEXECUTOR_H
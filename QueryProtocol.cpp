@@ -0,0 +1,60 @@
+#include "QueryProtocol.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <system_error>
+#include <sys/socket.h>
+
+#define SOCKET_BUFFER_SIZE (1 << 16)
+
+
+SocketStream::SocketStream(int socket) : socket(socket), buffer(SOCKET_BUFFER_SIZE) {}
+
+bool SocketStream::read(void* destination, uint64_t size) {
+    char* output = static_cast<char*>(destination);
+    while(size > 0) {
+        if(buffer_begin == buffer_end) {
+            ssize_t received = recv(socket, buffer.data(), buffer.size(), 0);
+            if(received < 0 && errno == EINTR) continue;
+            if(received < 0) throw std::system_error(errno, std::generic_category(), "Reading from the socket failed");
+            if(received == 0) return false;
+            buffer_begin = 0;
+            buffer_end = received;
+        }
+        uint64_t amount = std::min(size, buffer_end - buffer_begin);
+        std::memcpy(output, buffer.data() + buffer_begin, amount);
+        buffer_begin += amount;
+        output += amount;
+        size -= amount;
+    }
+    return true;
+}
+
+bool SocketStream::has_buffered() const {
+    return buffer_begin != buffer_end;
+}
+
+void SocketStream::write(std::span<const iovec> parts) {
+    std::vector<iovec> remaining(parts.begin(), parts.end());
+    uint64_t first = 0;
+    while(first < remaining.size()) {
+        msghdr message{};
+        message.msg_iov = remaining.data() + first;
+        message.msg_iovlen = std::min<uint64_t>(remaining.size() - first, IOV_MAX);
+        ssize_t sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+        if(sent < 0 && errno == EINTR) continue;
+        if(sent < 0) throw std::system_error(errno, std::generic_category(), "Writing to the socket failed");
+
+        // skip the parts that were sent completely and move into the one that was sent partially
+        uint64_t written = sent;
+        while(first < remaining.size() && written >= remaining[first].iov_len) {
+            written -= remaining[first].iov_len;
+            ++first;
+        }
+        if(written > 0) {
+            remaining[first].iov_base = static_cast<char*>(remaining[first].iov_base) + written;
+            remaining[first].iov_len -= written;
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <sys/uio.h>
+
+#ifndef TIMELINEINDEX_QUERYPROTOCOL_H
+#define TIMELINEINDEX_QUERYPROTOCOL_H
+
+/**
+ * @brief Requests understood by the QueryServer, with the layout of their payloads
+ * @details all numbers are in the byte order of the machine, the protocol is meant for a local socket.
+ * TIME_TRAVEL: uint64_t version, followed by the uint16_t indices of the projected columns.
+ * Answered with uint64_t rows, uint64_t columns and one array of rows uint64_t values per projected column.
+ * AGGREGATE: uint16_t AggregateType, uint16_t column. Answered with one uint64_t value per version.
+ * DIFF: uint64_t from version, uint64_t to version. Answered with uint64_t inserted, uint64_t deleted and the
+ * row ids of both as row_id_type, uint32_t or uint64_t with WIDE_IDS.
+ * APPEND: one WireEvent per event of the new version. Answered with the uint64_t number of the new version.
+ * AGGREGATE_ROLLUP: uint16_t AggregateType, uint16_t column, uint64_t bucket width. Answered with one RollupBucket
+ * per bucket, see TimelineIndex::temporal_sum_rollup.
+ */
+enum class Opcode : uint8_t {
+    TIME_TRAVEL,
+    AGGREGATE,
+    DIFF,
+    APPEND,
+    AGGREGATE_ROLLUP
+};
+
+/**
+ * @brief Result of a request, the payload of an ERROR response is the message of the error
+ */
+enum class Status : uint8_t {
+    OK,
+    ERROR
+};
+
+struct RequestHeader {
+    uint32_t request_id;
+    Opcode opcode;
+    uint8_t reserved[3];
+    uint32_t payload_size;
+};
+
+struct ResponseHeader {
+    uint32_t request_id;
+    Status status;
+    uint8_t reserved[3];
+    uint64_t payload_size;
+};
+
+struct WireEvent {
+    uint64_t row_id;
+    // 0 for insertions and 1 for deletions
+    uint64_t type;
+};
+
+/**
+ * @brief SocketStream class
+ * @details Buffered reads and gathered writes on a connected socket. Reads are served from a buffer that is
+ * refilled with as many bytes as the socket has, so pipelined messages only cost one system call per buffer.
+ * Writes take the parts of a message in place and hand them to the socket without copying them.
+ * Throws std::system_error if the socket fails.
+ */
+class SocketStream {
+    int socket;
+    std::vector<char> buffer;
+    uint64_t buffer_begin = 0;
+    uint64_t buffer_end = 0;
+
+public:
+    explicit SocketStream(int socket);
+
+    /**
+     * @brief Reads exactly size bytes
+     * @return false if the peer closed the connection before
+     */
+    bool read(void* destination, uint64_t size);
+
+    // true if bytes are buffered, e.g. because the peer pipelined several messages
+    bool has_buffered() const;
+
+    /**
+     * @brief Writes all parts in order
+     */
+    void write(std::span<const iovec> parts);
+};
+
+#endif //TIMELINEINDEX_QUERYPROTOCOL_H
@@ -0,0 +1,285 @@
+#include "QueryServer.h"
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define MAX_PAYLOAD_SIZE (1u << 30)
+#define FLUSH_SIZE (1u << 20) // bytes of responses after which the server writes even if more requests are buffered
+
+
+namespace {
+
+/**
+ * @brief Responses of a connection that were not written yet
+ * @details the iovecs point into the stored results, the deques keep their elements in place when they grow
+ */
+class ResponseQueue {
+    std::deque<ResponseHeader> headers;
+    std::deque<std::vector<uint64_t>> words;
+    std::deque<std::vector<row_id_type>> row_ids;
+    std::deque<std::string> messages;
+    std::vector<iovec> parts;
+    uint64_t bytes = 0;
+
+    void add_part(const void* data, uint64_t size) {
+        if(size == 0) return;
+        parts.push_back(iovec{const_cast<void*>(data), size});
+        bytes += size;
+    }
+
+public:
+    /**
+     * @brief Starts the response to a request, its payload follows with add
+     */
+    ResponseHeader& begin(uint32_t request_id, Status status) {
+        auto& header = headers.emplace_back();
+        header.request_id = request_id;
+        header.status = status;
+        add_part(&header, sizeof(header));
+        return header;
+    }
+
+    void add(ResponseHeader& header, std::vector<uint64_t>&& values) {
+        auto& stored = words.emplace_back(std::move(values));
+        header.payload_size += stored.size() * sizeof(uint64_t);
+        add_part(stored.data(), stored.size() * sizeof(uint64_t));
+    }
+
+    // a separate name, with WIDE_IDS row ids are uint64_t as well
+    void add_row_ids(ResponseHeader& header, std::vector<row_id_type>&& values) {
+        auto& stored = row_ids.emplace_back(std::move(values));
+        header.payload_size += stored.size() * sizeof(row_id_type);
+        add_part(stored.data(), stored.size() * sizeof(row_id_type));
+    }
+
+    void add_error(uint32_t request_id, std::string message) {
+        auto& header = begin(request_id, Status::ERROR);
+        auto& stored = messages.emplace_back(std::move(message));
+        header.payload_size = stored.size();
+        add_part(stored.data(), stored.size());
+    }
+
+    uint64_t size() const {
+        return bytes;
+    }
+
+    void flush(SocketStream& stream) {
+        stream.write(parts);
+        headers.clear();
+        words.clear();
+        row_ids.clear();
+        messages.clear();
+        parts.clear();
+        bytes = 0;
+    }
+};
+
+template<typename T>
+T read_value(const std::vector<char>& payload, uint64_t offset) {
+    if(offset + sizeof(T) > payload.size()) throw std::invalid_argument("Request is truncated");
+    T value;
+    std::memcpy(&value, payload.data() + offset, sizeof(T));
+    return value;
+}
+
+// the index answers versions after the latest one with the latest snapshot, remote clients get an error instead
+version read_version(TimelineIndex& index, const std::vector<char>& payload, uint64_t offset) {
+    auto result = read_value<uint64_t>(payload, offset);
+    if(result >= index.get_current_version()) throw std::invalid_argument("Version does not exist");
+    return result;
+}
+
+void answer(TimelineIndex& index, const RequestHeader& request, const std::vector<char>& payload, ResponseQueue& responses) {
+    switch(request.opcode) {
+        case Opcode::TIME_TRAVEL: {
+            auto query_version = read_version(index, payload, 0);
+            std::vector<uint16_t> projection((payload.size() - sizeof(uint64_t)) / sizeof(uint16_t));
+            for(uint64_t i=0; i<projection.size(); i++) {
+                projection[i] = read_value<uint16_t>(payload, sizeof(uint64_t) + i * sizeof(uint16_t));
+            }
+            if(projection.empty()) throw std::invalid_argument("Projection is empty");
+
+            auto snapshot = index.time_travel_projected(query_version, projection);
+            auto& header = responses.begin(request.request_id, Status::OK);
+            responses.add(header, std::vector<uint64_t>{snapshot.row_ids.size(), snapshot.columns.size()});
+            for(auto& column : snapshot.columns) {
+                responses.add(header, std::move(column));
+            }
+            break;
+        }
+        case Opcode::AGGREGATE: {
+            auto type = static_cast<AggregateType>(read_value<uint16_t>(payload, 0));
+            auto column = read_value<uint16_t>(payload, sizeof(uint16_t));
+            if(type != AggregateType::SUM && type != AggregateType::MAX) throw std::invalid_argument("Aggregate does not exist");
+
+            auto series = index.temporal_aggregates({{type, column}});
+            auto& header = responses.begin(request.request_id, Status::OK);
+            responses.add(header, std::move(series[0]));
+            break;
+        }
+        case Opcode::AGGREGATE_ROLLUP: {
+            auto type = static_cast<AggregateType>(read_value<uint16_t>(payload, 0));
+            auto column = read_value<uint16_t>(payload, sizeof(uint16_t));
+            auto bucket_width = read_value<uint64_t>(payload, 2 * sizeof(uint16_t));
+            if(type != AggregateType::SUM && type != AggregateType::MAX) throw std::invalid_argument("Aggregate does not exist");
+            if(bucket_width > std::numeric_limits<version>::max()) throw std::invalid_argument("Bucket width is too large");
+
+            auto buckets = type == AggregateType::SUM ? index.temporal_sum_rollup(column, bucket_width) : index.temporal_max_rollup(column, bucket_width);
+            // the buckets are few, copying them into words keeps the response queue simple
+            std::vector<uint64_t> words(buckets.size() * sizeof(RollupBucket) / sizeof(uint64_t));
+            std::memcpy(words.data(), buckets.data(), buckets.size() * sizeof(RollupBucket));
+            auto& header = responses.begin(request.request_id, Status::OK);
+            responses.add(header, std::move(words));
+            break;
+        }
+        case Opcode::DIFF: {
+            auto from_version = read_version(index, payload, 0);
+            auto to_version = read_version(index, payload, sizeof(uint64_t));
+
+            auto diff = index.diff(from_version, to_version);
+            auto& header = responses.begin(request.request_id, Status::OK);
+            responses.add(header, std::vector<uint64_t>{diff.inserted.size(), diff.deleted.size()});
+            responses.add_row_ids(header, std::move(diff.inserted));
+            responses.add_row_ids(header, std::move(diff.deleted));
+            break;
+        }
+        case Opcode::APPEND: {
+            if(payload.size() % sizeof(WireEvent) != 0) throw std::invalid_argument("Request is truncated");
+            std::vector<Event> events;
+            events.reserve(payload.size() / sizeof(WireEvent));
+            for(uint64_t offset = 0; offset < payload.size(); offset += sizeof(WireEvent)) {
+                auto event = read_value<WireEvent>(payload, offset);
+                if(event.type > 1) throw std::invalid_argument("Event type does not exist");
+                // larger ids would wrap around to an existing row
+                if(event.row_id > std::numeric_limits<row_id_type>::max()) throw std::invalid_argument("Row does not exist");
+                events.emplace_back(event.row_id, NO_ROW, event.type == 0 ? EventType::INSERT : EventType::DELETE);
+            }
+
+            index.append_version(events);
+            auto& header = responses.begin(request.request_id, Status::OK);
+            responses.add(header, std::vector<uint64_t>{index.get_current_version() - 1ull});
+            break;
+        }
+        default:
+            throw std::invalid_argument("Request does not exist");
+    }
+}
+
+}
+
+
+QueryServer::QueryServer(TimelineIndex& index, std::string socket_path) : index(index), socket_path(std::move(socket_path)) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(this->socket_path.size() >= sizeof(address.sun_path)) throw std::invalid_argument("Socket path is too long");
+    std::strcpy(address.sun_path, this->socket_path.c_str());
+
+    listening_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listening_socket < 0) throw std::system_error(errno, std::generic_category(), "Creating the socket failed");
+    unlink(this->socket_path.c_str());
+    if(bind(listening_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listening_socket, SOMAXCONN) < 0) {
+        int error = errno;
+        close(listening_socket);
+        throw std::system_error(error, std::generic_category(), "Listening on the socket failed");
+    }
+
+    acceptor = std::thread(&QueryServer::accept_connections, this);
+}
+
+QueryServer::~QueryServer() {
+    stop();
+}
+
+void QueryServer::stop() {
+    if(stopping.exchange(true)) return;
+
+    // wakes up the acceptor and all connections blocked in a read
+    shutdown(listening_socket, SHUT_RDWR);
+    acceptor.join();
+    close(listening_socket);
+    {
+        std::lock_guard lock(mutex);
+        for(auto& [socket, _] : connections) {
+            shutdown(socket, SHUT_RDWR);
+        }
+    }
+    // connections closing from now on leave their socket and thread to us
+    for(auto& [socket, connection] : connections) {
+        connection.join();
+        close(socket);
+    }
+    for(auto& connection : finished_connections) {
+        connection.join();
+    }
+    connections.clear();
+    finished_connections.clear();
+    unlink(socket_path.c_str());
+}
+
+void QueryServer::accept_connections() {
+    while(!stopping) {
+        int socket = accept(listening_socket, nullptr, nullptr);
+        if(socket < 0) {
+            if(errno == EINTR || errno == ECONNABORTED) continue;
+            return;
+        }
+
+        std::lock_guard lock(mutex);
+        if(stopping) {
+            close(socket);
+            return;
+        }
+        // finished threads only have to return after releasing the mutex
+        for(auto& connection : finished_connections) {
+            connection.join();
+        }
+        finished_connections.clear();
+        connections.emplace(socket, std::thread(&QueryServer::run_connection, this, socket));
+    }
+}
+
+void QueryServer::run_connection(int socket) {
+    serve(socket);
+
+    // the acceptor inserted this connection before releasing the mutex, so it is found here
+    std::lock_guard lock(mutex);
+    if(stopping) return;
+    auto connection = connections.find(socket);
+    finished_connections.push_back(std::move(connection->second));
+    connections.erase(connection);
+    // closed while holding the mutex, so a new connection reusing the number is only added after the erase
+    close(socket);
+}
+
+void QueryServer::serve(int socket) {
+    SocketStream stream(socket);
+    ResponseQueue responses;
+    RequestHeader request;
+    std::vector<char> payload;
+
+    try {
+        while(stream.read(&request, sizeof(request))) {
+            if(request.payload_size > MAX_PAYLOAD_SIZE) return;
+            payload.resize(request.payload_size);
+            if(!stream.read(payload.data(), payload.size())) return;
+
+            try {
+                answer(index, request, payload, responses);
+            } catch(const std::exception& error) {
+                responses.add_error(request.request_id, error.what());
+            }
+
+            if(!stream.has_buffered() || responses.size() > FLUSH_SIZE) {
+                responses.flush(stream);
+            }
+        }
+    } catch(const std::system_error&) {
+        // the client went away, its responses are dropped
+    }
+}
@@ -0,0 +1,52 @@
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "QueryProtocol.h"
+#include "TimelineIndex.h"
+
+#ifndef TIMELINEINDEX_QUERYSERVER_H
+#define TIMELINEINDEX_QUERYSERVER_H
+
+/**
+ * @brief QueryServer class
+ * @details Serves time travels, aggregates, diffs and appends on one TimelineIndex over a Unix domain socket,
+ * see QueryProtocol.h for the messages. Every connection has its own thread and answers its requests in order,
+ * clients may pipeline requests and match the responses by their request id. Responses are gathered from the
+ * query results in place and flushed once no further request is buffered, so pipelined requests share system calls.
+ * Concurrent connections are synchronized by the locks of the index. A closed connection releases its socket
+ * right away, its thread is joined when the next client connects.
+ */
+class QueryServer {
+    TimelineIndex& index;
+    const std::string socket_path;
+    int listening_socket;
+
+    std::thread acceptor;
+    std::mutex mutex;
+    // open connections by their socket, a connection moves its thread to finished_connections when it closes
+    std::unordered_map<int, std::thread> connections;
+    std::vector<std::thread> finished_connections;
+    std::atomic<bool> stopping = false;
+
+    void accept_connections();
+    void run_connection(int socket);
+    void serve(int socket);
+
+public:
+    /**
+     * @brief Starts listening on the socket path, an existing file at the path is replaced
+     * @details throws std::system_error if the socket can not be created
+     */
+    QueryServer(TimelineIndex& index, std::string socket_path);
+    ~QueryServer();
+
+    /**
+     * @brief Closes all connections and removes the socket file, requests in flight are dropped
+     */
+    void stop();
+};
+
+#endif //TIMELINEINDEX_QUERYSERVER_H
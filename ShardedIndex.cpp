@@ -0,0 +1,142 @@
+#include "ShardedIndex.h"
+#include "DistinctCounter.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+
+ShardedIndex::Shard::Shard(TemporalTable&& shard_table, std::vector<row_id_type>&& shard_row_ids)
+    : table(std::move(shard_table)), row_ids(std::move(shard_row_ids)), index(table) {}
+
+ShardedIndex::ShardedIndex(const TemporalTable& table, uint32_t shard_amount, ShardPartitioning partitioning, uint16_t key)
+    : shards(shard_amount), locations(table.get_table_size()) {
+    if(shard_amount == 0) throw std::invalid_argument("Number of shards must be larger than 0");
+
+    std::vector<std::vector<row_id_type>> row_ids(shard_amount);
+    for(row_id_type row_id = 0; row_id < table.get_table_size(); ++row_id) {
+        uint32_t shard;
+        if(partitioning == ShardPartitioning::ROW_RANGE) {
+            shard = static_cast<uint64_t>(row_id) * shard_amount / table.get_table_size();
+        } else {
+            auto values = table.row(row_id);
+            if(key >= values.size()) throw std::invalid_argument("Column does not exist");
+            shard = mix_bits(values[key]) % shard_amount;
+        }
+        locations[row_id] = {shard, static_cast<row_id_type>(row_ids[shard].size())};
+        row_ids[shard].push_back(row_id);
+    }
+
+    // every shard copies its rows and builds its index on its own thread
+    std::vector<std::exception_ptr> errors(shard_amount);
+    std::vector<std::thread> threads;
+    for(uint32_t i=0; i<shard_amount; i++) {
+        threads.emplace_back([&, i] {
+            try {
+                TemporalTable shard_table = table.row_width == 0
+                                            ? TemporalTable(table.next_version, row_ids[i].size())
+                                            : TemporalTable(table.next_version, row_ids[i].size(), table.row_width);
+                for(auto row_id : row_ids[i]) {
+                    shard_table.append_row(table.row(row_id), table.tuples[row_id].second);
+                }
+                shards[i] = std::make_unique<Shard>(std::move(shard_table), std::move(row_ids[i]));
+            } catch(...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    for(auto& error : errors) {
+        if(error) std::rethrow_exception(error);
+    }
+}
+
+uint32_t ShardedIndex::get_shard_amount() const {
+    return shards.size();
+}
+
+template<typename Result, typename Query>
+std::vector<Result> ShardedIndex::fan_out(Query query) const {
+    std::shared_lock queries(shard_lock);
+    std::vector<Result> results(shards.size());
+    std::vector<std::exception_ptr> errors(shards.size());
+    std::vector<std::thread> threads;
+
+    for(uint32_t i=0; i<shards.size(); i++) {
+        threads.emplace_back([&, i] {
+            try {
+                results[i] = query(*shards[i]);
+            } catch(...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    for(auto& error : errors) {
+        if(error) std::rethrow_exception(error);
+    }
+
+    return results;
+}
+
+void ShardedIndex::append_version(const std::vector<Event>& events) {
+    std::vector<std::vector<Event>> shard_events(shards.size());
+    for(auto& event : events) {
+        if(event.row_id >= locations.size()) throw std::invalid_argument("Row does not exist");
+        auto [shard, row_id] = locations[event.row_id];
+        shard_events[shard].emplace_back(row_id, NO_ROW, event.type);
+    }
+
+    // shards without events still get the version, so all of them keep the same version numbers
+    std::unique_lock append(shard_lock);
+    for(uint32_t i=0; i<shards.size(); i++) {
+        shards[i]->index.append_version(shard_events[i]);
+    }
+}
+
+std::vector<Tuple> ShardedIndex::time_travel(version query_version) const {
+    auto snapshots = fan_out<std::vector<Tuple>>([&](const Shard& shard) {return shard.index.time_travel(query_version);});
+
+    uint64_t size = 0;
+    for(auto& snapshot : snapshots) {
+        size += snapshot.size();
+    }
+    std::vector<Tuple> result;
+    result.reserve(size);
+    for(auto& snapshot : snapshots) {
+        std::move(snapshot.begin(), snapshot.end(), std::back_inserter(result));
+    }
+    return result;
+}
+
+std::vector<uint64_t> ShardedIndex::temporal_sum(uint16_t index) const {
+    return temporal_aggregates({{AggregateType::SUM, index}})[0];
+}
+
+std::vector<uint64_t> ShardedIndex::temporal_max(uint16_t index) const {
+    return temporal_aggregates({{AggregateType::MAX, index}})[0];
+}
+
+std::vector<std::vector<uint64_t>> ShardedIndex::temporal_aggregates(const std::vector<AggregateSpec>& aggregates) const {
+    auto shard_results = fan_out<std::vector<std::vector<uint64_t>>>([&](const Shard& shard) {
+        return shard.index.temporal_aggregates(aggregates);
+    });
+
+    auto result = std::move(shard_results[0]);
+    for(uint32_t i=1; i<shard_results.size(); i++) {
+        for(uint64_t j=0; j<aggregates.size(); j++) {
+            auto& merged = result[j];
+            auto& series = shard_results[i][j];
+            for(uint64_t v=0; v<merged.size(); v++) {
+                if(aggregates[j].type == AggregateType::MAX) merged[v] = std::max(merged[v], series[v]);
+                else merged[v] += series[v];
+            }
+        }
+    }
+    return result;
+}
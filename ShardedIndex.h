@@ -0,0 +1,83 @@
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+#include "TimelineIndex.h"
+
+#ifndef TIMELINEINDEX_SHARDEDINDEX_H
+#define TIMELINEINDEX_SHARDEDINDEX_H
+
+/**
+ * @brief How the rows of a table are distributed over the shards of a ShardedIndex
+ * @details ROW_RANGE gives every shard a contiguous range of row ids, KEY_HASH assigns a row by the hash of a column,
+ * so all rows with the same key end up in the same shard
+ */
+enum class ShardPartitioning {
+    ROW_RANGE,
+    KEY_HASH
+};
+
+/**
+ * @brief ShardedIndex class
+ * @details Partitions the rows of a table into independent shards, every shard owns a copy of its rows in its own
+ * TemporalTable and its own TimelineIndex with separate checkpoints, events and locks. Every shard is built by its own
+ * thread, the threads are not pinned, so there is no NUMA placement of the shards.
+ * Queries fan out to all shards in parallel and merge the results: snapshots are concatenated in shard order,
+ * sums are added and maxima combined. All shards share the version numbers of the source table.
+ * Queries hold the shard lock shared, append_version holds it exclusively, so a query never sees a version that
+ * only some of the shards have.
+ */
+class ShardedIndex {
+    struct Shard {
+        TemporalTable table;
+        // row id in the source table of every row of the shard
+        std::vector<row_id_type> row_ids;
+        TimelineIndex index;
+
+        Shard(TemporalTable&& shard_table, std::vector<row_id_type>&& shard_row_ids);
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    // shard and row id inside the shard of every source row
+    std::vector<std::pair<uint32_t, row_id_type>> locations;
+    mutable std::shared_mutex shard_lock;
+
+    /**
+     * @brief Runs query(shard) on one thread per shard
+     * @return the results in shard order
+     */
+    template<typename Result, typename Query>
+    std::vector<Result> fan_out(Query query) const;
+
+public:
+    /**
+     * @param table source table, it is only read during the construction
+     * @param shard_amount number of shards, at least 1
+     * @param partitioning
+     * @param key column hashed by KEY_HASH
+     */
+    ShardedIndex(const TemporalTable& table, uint32_t shard_amount, ShardPartitioning partitioning = ShardPartitioning::ROW_RANGE,
+                 uint16_t key = 0);
+
+    uint32_t get_shard_amount() const;
+
+    /**
+     * @brief Appends a version to every shard, events refer to row ids of the source table
+     */
+    void append_version(const std::vector<Event>& events);
+
+    /**
+     * @brief Time travel on all shards, with ROW_RANGE the tuples are in the same order as on a single index
+     */
+    std::vector<Tuple> time_travel(version query_version) const;
+
+    std::vector<uint64_t> temporal_sum(uint16_t index) const;
+    std::vector<uint64_t> temporal_max(uint16_t index) const;
+
+    /**
+     * @brief Computes several temporal aggregates on every shard with one replay each, see TimelineIndex::temporal_aggregates
+     */
+    std::vector<std::vector<uint64_t>> temporal_aggregates(const std::vector<AggregateSpec>& aggregates) const;
+};
+
+#endif //TIMELINEINDEX_SHARDEDINDEX_H
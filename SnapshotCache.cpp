@@ -0,0 +1,87 @@
+#include "SnapshotCache.h"
+
+
+SnapshotCache::SnapshotCache(uint64_t budget) : budget(budget) {}
+
+SnapshotCache::SnapshotCache(const SnapshotCache& other) : budget(other.budget) {}
+
+void SnapshotCache::set_budget(uint64_t new_budget) {
+    std::lock_guard lock(mutex);
+    budget = new_budget;
+    evict();
+}
+
+void SnapshotCache::evict() {
+    while(used_bytes > budget && !lru.empty()) {
+        auto entry = entries.find(lru.back());
+        used_bytes -= entry->second.bytes;
+        entries.erase(entry);
+        lru.pop_back();
+    }
+}
+
+std::optional<std::pair<version, checkpoint>> SnapshotCache::find_nearest(version query_version, version max_distance) {
+    std::lock_guard lock(mutex);
+    if(entries.empty()) return std::nullopt;
+
+    auto best = entries.end();
+    version best_distance = max_distance;
+
+    auto it = entries.lower_bound(query_version);
+    if(it != entries.end() && it->first - query_version < best_distance) {
+        best = it;
+        best_distance = it->first - query_version;
+    }
+    if(it != entries.begin()) {
+        --it;
+        if(query_version - it->first < best_distance) {
+            best = it;
+        }
+    }
+
+    if(best == entries.end()) return std::nullopt;
+
+    lru.splice(lru.begin(), lru, best->second.lru_position);
+    return std::pair{best->first, best->second.bitset};
+}
+
+void SnapshotCache::insert(version snapshot_version, const checkpoint& bitset) {
+    {
+        std::lock_guard lock(mutex);
+        if(budget == 0 || entries.contains(snapshot_version)) return;
+    }
+
+    // copy and measure outside of the lock, this is the expensive part
+    checkpoint copy(bitset);
+    uint64_t bytes = copy.memory_usage();
+
+    std::lock_guard lock(mutex);
+    if(bytes > budget || entries.contains(snapshot_version)) return;
+
+    lru.push_front(snapshot_version);
+    entries.emplace(snapshot_version, Entry{std::move(copy), bytes, lru.begin()});
+    used_bytes += bytes;
+    evict();
+}
+
+void SnapshotCache::clear() {
+    std::lock_guard lock(mutex);
+    entries.clear();
+    lru.clear();
+    used_bytes = 0;
+}
+
+void SnapshotCache::drop_before(version snapshot_version) {
+    std::lock_guard lock(mutex);
+    auto end = entries.lower_bound(snapshot_version);
+    for(auto it = entries.begin(); it != end; ++it) {
+        used_bytes -= it->second.bytes;
+        lru.erase(it->second.lru_position);
+    }
+    entries.erase(entries.begin(), end);
+}
+
+uint64_t SnapshotCache::memory_usage() const {
+    std::lock_guard lock(mutex);
+    return used_bytes;
+}
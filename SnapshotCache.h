@@ -0,0 +1,61 @@
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include "TemporalTable.h"
+
+#ifndef TIMELINEINDEX_SNAPSHOTCACHE_H
+#define TIMELINEINDEX_SNAPSHOTCACHE_H
+
+/**
+ * @brief SnapshotCache class
+ * @details Bounded LRU cache of reconstructed live sets, keyed by their version.
+ * The TimelineIndex uses the cached snapshots as additional checkpoints for time travels close to hot versions.
+ * The size of the cache is limited by a byte budget, a budget of 0 disables the cache.
+ */
+class SnapshotCache {
+    struct Entry {
+        checkpoint bitset;
+        uint64_t bytes;
+        std::list<version>::iterator lru_position;
+    };
+
+    std::map<version, Entry> entries;
+    // front is the most recently used version
+    std::list<version> lru;
+    uint64_t budget;
+    uint64_t used_bytes = 0;
+    mutable std::mutex mutex;
+
+    void evict();
+
+public:
+    explicit SnapshotCache(uint64_t budget = 0);
+
+    // copies only the budget, the cached snapshots stay with the original index
+    SnapshotCache(const SnapshotCache& other);
+
+    void set_budget(uint64_t new_budget);
+
+    /**
+     * @brief Returns the cached snapshot closest to the query version
+     * @param query_version
+     * @param max_distance only snapshots strictly closer than this are returned
+     * @return copy of the snapshot and its version
+     */
+    std::optional<std::pair<version, checkpoint>> find_nearest(version query_version, version max_distance);
+
+    /**
+     * @brief Caches the live set of the given version, evicting the least recently used snapshots if necessary
+     */
+    void insert(version snapshot_version, const checkpoint& bitset);
+
+    void clear();
+
+    // removes all snapshots of versions before the given one
+    void drop_before(version snapshot_version);
+    uint64_t memory_usage() const;
+};
+
+#endif //TIMELINEINDEX_SNAPSHOTCACHE_H
@@ -0,0 +1,299 @@
+#include "TableLoader.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#define LOAD_BLOCK_SIZE 4096 // records read at once by a thread of the binary loader
+#define NO_END std::numeric_limits<version>::max()
+
+
+namespace {
+
+/**
+ * @brief Stores one record as row row_id of the preallocated table and counts its events
+ */
+void store_row(TemporalTable& table, uint64_t row_id, const uint64_t* values, version start, version end,
+               std::vector<event_offset>& histogram) {
+    // the version map only holds events before next_version
+    if(start >= table.next_version || (end != NO_END && (end <= start || end >= table.next_version))) {
+        throw std::invalid_argument("Record has versions outside of the table");
+    }
+    std::memcpy(table.arena.data() + row_id * table.row_width, values, table.row_width * sizeof(uint64_t));
+    auto& lifespan = table.tuples[row_id].second;
+    lifespan.start = start;
+    if(end != NO_END) lifespan.end = end;
+
+    if(!histogram.empty()) {
+        ++histogram[start];
+        if(end != NO_END) ++histogram[end];
+    }
+}
+
+/**
+ * @brief Sizes the empty table for the rows of the file
+ * @return the row width the table had before, run_threads restores it if loading fails
+ */
+uint16_t prepare_table(TemporalTable& table, uint64_t columns, uint64_t rows) {
+    if(!table.tuples.empty()) throw std::invalid_argument("Table is not empty");
+    if(columns == 0 || columns > UINT16_MAX) throw std::invalid_argument("Number of columns is not supported");
+    if(table.row_width != 0 && table.row_width != columns) throw std::invalid_argument("File does not match the row width");
+    uint16_t row_width = table.row_width;
+    table.row_width = columns;
+    table.arena.resize(rows * columns);
+    table.tuples.resize(rows);
+    return row_width;
+}
+
+/**
+ * @brief Runs body(thread) on every thread
+ * @details rethrows the first error of the threads after all of them finished
+ */
+template<typename Body>
+void run_parallel(uint32_t thread_amount, Body body) {
+    std::vector<std::exception_ptr> errors(thread_amount);
+    std::vector<std::thread> threads;
+
+    for(uint32_t i=0; i<thread_amount; i++) {
+        threads.emplace_back([&, i] {
+            try {
+                body(i);
+            } catch(...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    for(auto& error : errors) {
+        if(error) std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief Runs body(thread, histogram) on every thread and sums up their histograms
+ * @details rethrows the first error of the threads after all of them finished, the table is emptied and gets
+ * back the row width it had before prepare_table in that case
+ */
+template<typename Body>
+std::vector<event_offset> run_threads(TemporalTable& table, uint16_t row_width, uint32_t thread_amount, bool build_histogram, Body body) {
+    std::vector<std::vector<event_offset>> histograms(thread_amount);
+
+    try {
+        run_parallel(thread_amount, [&](uint32_t thread) {
+            if(build_histogram) histograms[thread].assign(table.next_version, 0);
+            body(thread, histograms[thread]);
+        });
+    } catch(...) {
+        table.tuples.clear();
+        table.arena.clear();
+        table.row_width = row_width;
+        throw;
+    }
+
+    if(!build_histogram) return {};
+    for(uint32_t i=1; i<thread_amount; i++) {
+        for(uint64_t j=0; j<histograms[0].size(); j++) {
+            histograms[0][j] += histograms[i][j];
+        }
+    }
+    return std::move(histograms[0]);
+}
+
+/**
+ * @brief Loads a file without rows, the table stays empty and keeps its row width
+ */
+std::vector<event_offset> load_empty(const TemporalTable& table, bool build_histogram) {
+    if(!table.tuples.empty()) throw std::invalid_argument("Table is not empty");
+    if(!build_histogram) return {};
+    return std::vector<event_offset>(table.next_version, 0);
+}
+
+std::ifstream open_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if(!file) throw std::invalid_argument("File can not be opened");
+    return file;
+}
+
+template<typename T>
+const char* parse_field(const char* begin, const char* end, T& value) {
+    auto [pointer, error] = std::from_chars(begin, end, value);
+    if(error != std::errc() || (pointer != end && *pointer != ',')) throw std::invalid_argument("Record is malformed");
+    return pointer;
+}
+
+}
+
+
+TableLoader::TableLoader(std::string path, FileFormat format, uint32_t thread_amount) : path(std::move(path)), format(format), thread_amount(thread_amount) {
+    if(thread_amount == 0) throw std::invalid_argument("Number of threads must be larger than 0");
+}
+
+std::vector<event_offset> TableLoader::load(TemporalTable& table, bool build_histogram) const {
+    if(format == FileFormat::BINARY) return load_binary(table, build_histogram);
+    return load_csv(table, build_histogram);
+}
+
+std::vector<event_offset> TableLoader::load_binary(TemporalTable& table, bool build_histogram) const {
+    auto file = open_file(path);
+    uint64_t columns = 0;
+    if(!file.read(reinterpret_cast<char*>(&columns), sizeof(columns))) throw std::invalid_argument("File has no header");
+
+    uint64_t file_size = std::filesystem::file_size(path) - sizeof(columns);
+    // an empty table without a row width is written with 0 columns
+    if(columns == 0) {
+        if(file_size != 0) throw std::invalid_argument("File is truncated");
+        return load_empty(table, build_histogram);
+    }
+    // a corrupt header must not wrap the record size
+    if(columns > UINT16_MAX) throw std::invalid_argument("Number of columns is not supported");
+    uint64_t record_size = columns * sizeof(uint64_t) + 2 * sizeof(version);
+    if(file_size % record_size != 0) throw std::invalid_argument("File is truncated");
+    uint64_t rows = file_size / record_size;
+    uint16_t row_width = prepare_table(table, columns, rows);
+
+    return run_threads(table, row_width, thread_amount, build_histogram, [&](uint32_t thread, std::vector<event_offset>& histogram) {
+        uint64_t first_row = rows * thread / thread_amount;
+        uint64_t last_row = rows * (thread + 1) / thread_amount;
+        auto chunk = open_file(path);
+        chunk.seekg(sizeof(columns) + first_row * record_size);
+
+        std::vector<char> buffer(LOAD_BLOCK_SIZE * record_size);
+        std::vector<uint64_t> values(columns);
+        for(uint64_t row_id = first_row; row_id < last_row; row_id += LOAD_BLOCK_SIZE) {
+            uint64_t block_rows = std::min<uint64_t>(LOAD_BLOCK_SIZE, last_row - row_id);
+            if(!chunk.read(buffer.data(), block_rows * record_size)) throw std::invalid_argument("File is truncated");
+
+            const char* record = buffer.data();
+            for(uint64_t i=0; i<block_rows; i++, record += record_size) {
+                // records are not aligned within the buffer
+                version versions[2];
+                std::memcpy(values.data(), record, columns * sizeof(uint64_t));
+                std::memcpy(versions, record + columns * sizeof(uint64_t), sizeof(versions));
+                store_row(table, row_id + i, values.data(), versions[0], versions[1], histogram);
+            }
+        }
+    });
+}
+
+std::vector<event_offset> TableLoader::load_csv(TemporalTable& table, bool build_histogram) const {
+    auto file = open_file(path);
+    uint64_t file_size = std::filesystem::file_size(path);
+    if(file_size == 0) return load_empty(table, build_histogram);
+
+    // the number of columns follows from the first line
+    std::string line;
+    std::getline(file, line);
+    uint64_t fields = std::count(line.begin(), line.end(), ',') + 1;
+    if(fields < 3) throw std::invalid_argument("Record is malformed");
+    uint64_t columns = fields - 2;
+
+    // move the chunk borders behind the next line break, so every chunk holds whole lines
+    std::vector<uint64_t> borders{0};
+    for(uint32_t i=1; i<thread_amount; i++) {
+        uint64_t border = std::max(file_size * i / thread_amount, borders.back());
+        if(border > 0 && border < file_size) {
+            file.clear();
+            file.seekg(border - 1);
+            std::getline(file, line);
+            border = file ? static_cast<uint64_t>(file.tellg()) : file_size;
+        }
+        borders.push_back(std::min(border, file_size));
+    }
+    borders.push_back(file_size);
+
+    // first pass: read every chunk and count its lines to know where its rows start
+    std::vector<std::string> chunks(thread_amount);
+    std::vector<uint64_t> first_rows(thread_amount + 1, 0);
+    run_parallel(thread_amount, [&](uint32_t thread) {
+        auto chunk = open_file(path);
+        chunk.seekg(borders[thread]);
+        chunks[thread].resize(borders[thread + 1] - borders[thread]);
+        if(!chunk.read(chunks[thread].data(), chunks[thread].size())) throw std::invalid_argument("File can not be read");
+        uint64_t rows = std::count(chunks[thread].begin(), chunks[thread].end(), '\n');
+        // the last line may miss its line break
+        if(!chunks[thread].empty() && chunks[thread].back() != '\n') ++rows;
+        first_rows[thread + 1] = rows;
+    });
+    for(uint32_t i=0; i<thread_amount; i++) {
+        first_rows[i + 1] += first_rows[i];
+    }
+    uint16_t row_width = prepare_table(table, columns, first_rows.back());
+
+    // second pass: parse the lines straight into the table
+    return run_threads(table, row_width, thread_amount, build_histogram, [&](uint32_t thread, std::vector<event_offset>& histogram) {
+        std::string_view chunk = chunks[thread];
+        std::vector<uint64_t> values(columns);
+        uint64_t row_id = first_rows[thread];
+
+        while(!chunk.empty()) {
+            uint64_t line_end = std::min(chunk.find('\n'), chunk.size());
+            std::string_view record = chunk.substr(0, line_end);
+            chunk.remove_prefix(std::min(line_end + 1, chunk.size()));
+            if(!record.empty() && record.back() == '\r') record.remove_suffix(1);
+
+            const char* position = record.data();
+            const char* end = record.data() + record.size();
+            for(auto& value : values) {
+                position = parse_field(position, end, value);
+                if(position == end) throw std::invalid_argument("Record is malformed");
+                ++position;
+            }
+            version start = 0;
+            version ending_version = NO_END;
+            position = parse_field(position, end, start);
+            if(position == end) throw std::invalid_argument("Record is malformed");
+            ++position;
+            if(position != end && parse_field(position, end, ending_version) != end) throw std::invalid_argument("Record is malformed");
+
+            store_row(table, row_id++, values.data(), start, ending_version, histogram);
+        }
+    });
+}
+
+void TableLoader::write(const TemporalTable& table, const std::string& path, FileFormat format) {
+    std::ofstream file(path, std::ios::binary);
+    if(!file) throw std::invalid_argument("File can not be opened");
+
+    // the header of an empty table holds its row width, 0 for tables without an arena
+    uint64_t columns = table.tuples.empty() ? table.row_width : table.row(0).size();
+    if(format == FileFormat::BINARY) {
+        file.write(reinterpret_cast<const char*>(&columns), sizeof(columns));
+    }
+
+    std::string line;
+    for(row_id_type row_id = 0; row_id < table.tuples.size(); ++row_id) {
+        auto values = table.row(row_id);
+        if(values.size() != columns) throw std::invalid_argument("Row was reclaimed or has a different width");
+        auto& lifespan = table.tuples[row_id].second;
+
+        if(format == FileFormat::BINARY) {
+            version versions[2] = {lifespan.start, lifespan.end.value_or(NO_END)};
+            file.write(reinterpret_cast<const char*>(values.data()), values.size_bytes());
+            file.write(reinterpret_cast<const char*>(versions), sizeof(versions));
+            continue;
+        }
+
+        line.clear();
+        for(auto value : values) {
+            line += std::to_string(value);
+            line += ',';
+        }
+        line += std::to_string(lifespan.start);
+        line += ',';
+        if(lifespan.end.has_value()) line += std::to_string(lifespan.end.value());
+        line += '\n';
+        file << line;
+    }
+
+    if(!file) throw std::invalid_argument("File can not be written");
+}
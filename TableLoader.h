@@ -0,0 +1,60 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "TemporalTable.h"
+
+#ifndef TIMELINEINDEX_TABLELOADER_H
+#define TIMELINEINDEX_TABLELOADER_H
+
+/**
+ * @brief Formats of the files read by a TableLoader
+ * @details BINARY starts with the number of columns as uint64_t, followed by one record per row: the column values
+ * as uint64_t, the start version and the end version as version, its largest value if the row was never deleted.
+ * All numbers are in the byte order and version width of the build, see IndexTypes.h. A file of an empty table
+ * without an arena has 0 columns and no records.
+ * CSV holds one row per line, the column values followed by the start and the end version, the end is empty
+ * if the row was never deleted.
+ */
+enum class FileFormat {
+    BINARY,
+    CSV
+};
+
+/**
+ * @brief TableLoader class
+ * @details Loads the rows of a file into the arena of a TemporalTable. The file is split into one chunk per thread,
+ * the chunks are parsed in parallel and every thread writes its rows straight into the preallocated arena,
+ * so the row ids follow the order of the file. CSV files are read twice, once to count the rows of every chunk.
+ * Optionally the threads count the events of every version on the way, the histogram replaces the counting pass
+ * when the TimelineIndex is built afterwards.
+ */
+class TableLoader {
+    const std::string path;
+    const FileFormat format;
+    const uint32_t thread_amount;
+
+    std::vector<event_offset> load_binary(TemporalTable& table, bool build_histogram) const;
+    std::vector<event_offset> load_csv(TemporalTable& table, bool build_histogram) const;
+
+public:
+    TableLoader(std::string path, FileFormat format, uint32_t thread_amount = 4);
+
+    /**
+     * @brief Loads all rows of the file into the empty table
+     * @details the table gets an arena with one column per value of a record. Throws std::invalid_argument
+     * if the table is not empty, the file can not be read or a record is malformed or has versions outside
+     * of the table, the table stays empty and keeps its row width in that case. Files without rows leave the table empty
+     * @param table
+     * @param build_histogram
+     * @return number of events per version if build_histogram is set, see TimelineIndex, otherwise empty
+     */
+    std::vector<event_offset> load(TemporalTable& table, bool build_histogram = false) const;
+
+    /**
+     * @brief Writes all rows of the table to a file that can be loaded again
+     * @details throws std::invalid_argument if a row was reclaimed, a BINARY file of an empty table still gets its header
+     */
+    static void write(const TemporalTable& table, const std::string& path, FileFormat format);
+};
+
+#endif //TIMELINEINDEX_TABLELOADER_H
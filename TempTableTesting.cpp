@@ -3,27 +3,33 @@
 //
 
 #include <iostream>
+#include <unordered_set>
+#include <algorithm>
+#include <cmath>
 #include "TemporalTable.h"
 #include "TimelineIndex.h"
 
-std::vector<Tuple> TemporalTable::time_travel(uint32_t query_version) {
+std::vector<Tuple> TemporalTable::time_travel(version query_version) const {
     std::vector<Tuple> result;
-    for(auto& tuple : tuples) {
-        if(tuple.second.start <= query_version && (!tuple.second.end.has_value() || tuple.second.end.value() > query_version)) {
-            result.push_back(tuple.first);
+    for(row_id_type row_id=0; row_id<tuples.size(); row_id++) {
+        auto& lifespan = tuples[row_id].second;
+        if(lifespan.start <= query_version && (!lifespan.end.has_value() || lifespan.end.value() > query_version)) {
+            auto values = row(row_id);
+            result.emplace_back(values.begin(), values.end());
         }
     }
     return result;
 }
 
-std::vector<uint64_t> TemporalTable::temporal_sum(uint16_t index) {
+std::vector<uint64_t> TemporalTable::temporal_sum(uint16_t index) const {
     std::vector<uint64_t> result;
     // for each version check what tuples are currently in the version
-    for(uint32_t i=0; i<next_version; i++) {
+    for(version i=0; i<next_version; i++) {
         uint64_t current_sum = 0;
-        for(auto& [tuple, lifespan] : tuples) {
+        for(row_id_type row_id=0; row_id<tuples.size(); row_id++) {
+            auto& lifespan = tuples[row_id].second;
             if(lifespan.start <= i && (!lifespan.end.has_value() || lifespan.end.value() > i)) {
-                current_sum += tuple[index];
+                current_sum += row(row_id)[index];
             }
         }
         result.push_back(current_sum);
@@ -31,33 +37,124 @@ std::vector<uint64_t> TemporalTable::temporal_sum(uint16_t index) {
     return result;
 }
 
-std::vector<uint64_t> TemporalTable::temporal_max(uint16_t index) {
+std::vector<uint64_t> TemporalTable::temporal_max(uint16_t index) const {
     // same thing as temporal_sum, but with max
     std::vector<uint64_t> result;
     // for each version check what tuples are currently in the version
-    for(uint32_t i=0; i<next_version; i++) {
+    for(version i=0; i<next_version; i++) {
         uint64_t current_max = 0;
-        for(auto& tuple : tuples) {
-            if(tuple.second.start <= i && (!tuple.second.end.has_value() || tuple.second.end.value() > i)) {
-                current_max = std::max(current_max, tuple.first[index]);
+        for(row_id_type row_id=0; row_id<tuples.size(); row_id++) {
+            auto& lifespan = tuples[row_id].second;
+            if(lifespan.start <= i && (!lifespan.end.has_value() || lifespan.end.value() > i)) {
+                current_max = std::max(current_max, row(row_id)[index]);
             }
         }
         result.push_back(current_max);
     }
     return result;
 }
+std::vector<uint64_t> TemporalTable::temporal_count_distinct(uint16_t index) const {
+    std::vector<uint64_t> result;
+    for(version i=0; i<next_version; i++) {
+        std::unordered_set<uint64_t> values;
+        for(row_id_type row_id=0; row_id<tuples.size(); row_id++) {
+            auto& lifespan = tuples[row_id].second;
+            if(lifespan.start <= i && (!lifespan.end.has_value() || lifespan.end.value() > i)) {
+                values.insert(row(row_id)[index]);
+            }
+        }
+        result.push_back(values.size());
+    }
+    return result;
+}
+std::vector<std::vector<uint64_t>> TemporalTable::temporal_quantiles(uint16_t index, const std::vector<double>& quantiles) const {
+    std::vector<std::vector<uint64_t>> result(quantiles.size());
+    for(version i=0; i<next_version; i++) {
+        std::vector<uint64_t> values;
+        for(row_id_type row_id=0; row_id<tuples.size(); row_id++) {
+            auto& lifespan = tuples[row_id].second;
+            if(lifespan.start <= i && (!lifespan.end.has_value() || lifespan.end.value() > i)) {
+                values.push_back(row(row_id)[index]);
+            }
+        }
+        std::sort(values.begin(), values.end());
+        for(uint64_t q=0; q<quantiles.size(); q++) {
+            uint64_t rank = std::max<uint64_t>(1, std::ceil(quantiles[q] * values.size()));
+            result[q].push_back(values.empty() ? 0 : values[rank - 1]);
+        }
+    }
+    return result;
+}
+std::vector<std::vector<row_id_type>> TemporalTable::temporal_top_k(uint16_t index, uint32_t k) const {
+    std::vector<std::vector<row_id_type>> result;
+    for(version i=0; i<next_version; i++) {
+        std::vector<std::pair<uint64_t, row_id_type>> values;
+        for(row_id_type row_id=0; row_id<tuples.size(); row_id++) {
+            auto& lifespan = tuples[row_id].second;
+            if(lifespan.start <= i && (!lifespan.end.has_value() || lifespan.end.value() > i)) {
+                // negated value sorts descending by value and ascending by row id
+                values.emplace_back(-row(row_id)[index], row_id);
+            }
+        }
+        std::sort(values.begin(), values.end());
+        std::vector<row_id_type> top;
+        for(uint64_t j=0; j<std::min<uint64_t>(k, values.size()); j++) {
+            top.push_back(values[j].second);
+        }
+        std::sort(top.begin(), top.end());
+        result.push_back(std::move(top));
+    }
+    return result;
+}
 
+TypedSeries TemporalTable::temporal_sum_typed(uint16_t typed_column) const {
+    return std::visit([&](const auto& column) -> TypedSeries {
+        std::vector<AccumulatorType<typename std::decay_t<decltype(column)>::value_type>> result;
+        for(version i=0; i<next_version; i++) {
+            typename decltype(result)::value_type current_sum = 0;
+            for(row_id_type row_id=0; row_id<tuples.size(); row_id++) {
+                auto& lifespan = tuples[row_id].second;
+                if(lifespan.start <= i && (!lifespan.end.has_value() || lifespan.end.value() > i)) {
+                    current_sum += column[row_id];
+                }
+            }
+            result.push_back(current_sum);
+        }
+        return result;
+    }, get_typed_column(typed_column));
+}
+
+TypedSeries TemporalTable::temporal_max_typed(uint16_t typed_column) const {
+    return std::visit([&](const auto& column) -> TypedSeries {
+        std::vector<AccumulatorType<typename std::decay_t<decltype(column)>::value_type>> result;
+        for(version i=0; i<next_version; i++) {
+            // signed values may all be negative, 0 only if no row is alive
+            std::optional<typename decltype(result)::value_type> current_max;
+            for(row_id_type row_id=0; row_id<tuples.size(); row_id++) {
+                auto& lifespan = tuples[row_id].second;
+                if(lifespan.start <= i && (!lifespan.end.has_value() || lifespan.end.value() > i)) {
+                    current_max = std::max<typename decltype(result)::value_type>(current_max.value_or(column[row_id]), column[row_id]);
+                }
+            }
+            result.push_back(current_max.value_or(0));
+        }
+        return result;
+    }, get_typed_column(typed_column));
+}
 
-TemporalTable TemporalTable::temporal_join(TemporalTable&other, uint16_t index) {
+TemporalTable TemporalTable::temporal_join(const TemporalTable& other, uint16_t index) const {
     // literally slowest algo ever O(n*m)
 
     TemporalTable result(std::max(next_version, other.next_version), 0);
 
-    for(auto [tuple_a, lifespan_a] : tuples) {
-        for(auto [tuple_b, lifespan_b] : other.tuples) {
-            if(tuple_a[index] == tuple_b[index]) {
-                uint32_t new_start = std::max(lifespan_a.start, lifespan_b.start);
-                std::optional<uint32_t> new_end;
+    for(row_id_type row_a=0; row_a<tuples.size(); row_a++) {
+        auto tuple_a = row(row_a);
+        auto& lifespan_a = tuples[row_a].second;
+        for(row_id_type row_b=0; row_b<other.tuples.size(); row_b++) {
+            auto& lifespan_b = other.tuples[row_b].second;
+            if(tuple_a[index] == other.row(row_b)[index]) {
+                version new_start = std::max(lifespan_a.start, lifespan_b.start);
+                std::optional<version> new_end;
                 if(lifespan_a.end.has_value() && lifespan_b.end.has_value()) {
                     new_end = std::min(lifespan_a.end.value(), lifespan_b.end.value());
                 } else if(lifespan_a.end.has_value()) {
@@ -72,7 +169,7 @@ TemporalTable TemporalTable::temporal_join(TemporalTable&other, uint16_t index)
                     continue;
                 }
 
-                result.tuples.emplace_back(tuple_a, LifeSpan{new_start, new_end});
+                result.append_row(tuple_a, LifeSpan{new_start, new_end});
             }
         }
     }
@@ -82,7 +179,7 @@ TemporalTable TemporalTable::temporal_join(TemporalTable&other, uint16_t index)
 
 
 // this method computes the time travel of joined tables. It does not utilize checkpoints and therefore is not relevant and just here for testing purposes
-std::vector<Tuple> TimelineIndex::time_travel_joined(version query_version) {
+std::vector<Tuple> TimelineIndex::time_travel_joined(version query_version) const {
     std::vector<Tuple> result;
 
     // the main difference will be that we construct a vector of uint32_t instead a bitset to allow having some
@@ -99,8 +196,9 @@ std::vector<Tuple> TimelineIndex::time_travel_joined(version query_version) {
     }
 
     for(int i=0; i<row_ids.size(); i++) {
+        auto values = table.row(i);
         for(int u=0; u<row_ids[i]; u++) {
-            result.push_back(table.tuples[i].first);
+            result.emplace_back(values.begin(), values.end());
         }
     }
 
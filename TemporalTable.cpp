@@ -2,17 +2,36 @@
 // Created by Peter Pashkin on 04.12.23.
 //
 #include "TemporalTable.h"
+#include <algorithm>
+#include <stdexcept>
 
+#define ZONE_MAP_BLOCK_SIZE 1024
 
-TemporalTable::TemporalTable(uint32_t version_number, uint64_t tuples_size) : next_version(version_number) {
+
+TemporalTable::TemporalTable(version version_number, uint64_t tuples_size) : next_version(version_number) {
     tuples.reserve(tuples_size);
 }
 
-uint64_t TemporalTable::get_table_size() {
+TemporalTable::TemporalTable(version version_number, uint64_t tuples_size, uint16_t row_width) : next_version(version_number), row_width(row_width) {
+    if(row_width == 0) throw std::invalid_argument("Row width must not be 0");
+    tuples.reserve(tuples_size);
+    arena.reserve(tuples_size * row_width);
+}
+
+uint64_t TemporalTable::get_table_size() const {
     return tuples.size();
 }
 
-std::vector<Tuple> TemporalTable::get_tuples(checkpoint& bitset) {
+bool TemporalTable::has_column(uint16_t index) const {
+    if(row_width != 0) return index < row_width;
+    // all rows have the same width, reclaimed rows are empty and usually the oldest ones
+    for(auto tuple = tuples.rbegin(); tuple != tuples.rend(); ++tuple) {
+        if(!tuple->first.empty()) return index < tuple->first.size();
+    }
+    return true;
+}
+
+std::vector<Tuple> TemporalTable::get_tuples(const checkpoint& bitset) const {
     std::vector<Tuple> result;
     result.reserve(bitset.get_set_bits());
     std::vector<uint64_t> set_bits;
@@ -22,13 +41,235 @@ std::vector<Tuple> TemporalTable::get_tuples(checkpoint& bitset) {
     bitset.fill_bits(set_bits);
 
     for(auto index: set_bits) {
-        result.push_back(tuples[index].first);
+        auto values = row(index);
+        result.emplace_back(values.begin(), values.end());
+    }
+
+    return result;
+}
+
+std::vector<Tuple> TemporalTable::get_tuples(const checkpoint& bitset, const std::vector<Predicate>& predicates) const {
+    auto row_ids = select_rows(bitset, predicates);
+    std::vector<Tuple> result;
+    result.reserve(row_ids.size());
+    for(auto row_id : row_ids) {
+        auto values = row(row_id);
+        result.emplace_back(values.begin(), values.end());
+    }
+    return result;
+}
+
+uint16_t TemporalTable::add_typed_column(TypedColumn column) {
+    auto size = std::visit([](const auto& values) {return values.size();}, column);
+    if(size != tuples.size()) throw std::invalid_argument("Typed column does not match the number of rows");
+    typed_columns.push_back(std::move(column));
+    return typed_columns.size() - 1;
+}
+
+const TypedColumn& TemporalTable::get_typed_column(uint16_t typed_column) const {
+    if(typed_column >= typed_columns.size()) throw std::invalid_argument("Typed column does not exist");
+    auto& column = typed_columns[typed_column];
+    // rows appended after the column was added have no value
+    auto size = std::visit([](const auto& values) {return values.size();}, column);
+    if(size < tuples.size()) throw std::invalid_argument("Typed column does not cover all rows");
+    return column;
+}
+
+ColumnType TemporalTable::get_column_type(uint16_t typed_column) const {
+    return static_cast<ColumnType>(get_typed_column(typed_column).index());
+}
+
+std::vector<row_id_type> TemporalTable::select_rows(const checkpoint& bitset, const std::vector<Predicate>& predicates) const {
+    std::vector<row_id_type> result;
+    if(predicates.empty()) {
+        std::vector<uint64_t> set_bits;
+        set_bits.reserve(bitset.get_set_bits());
+        bitset.fill_bits(set_bits);
+        result.assign(set_bits.begin(), set_bits.end());
+        return result;
+    }
+
+    for(auto& predicate : predicates) {
+        if(!has_column(predicate.index)) throw std::invalid_argument("Column does not exist");
+    }
+
+    std::vector<row_id_type> selection;
+    selection.reserve(ZONE_MAP_BLOCK_SIZE);
+
+    std::optional<uint64_t> current = bitset.min();
+    while(current.has_value()) {
+        uint64_t block = current.value() / ZONE_MAP_BLOCK_SIZE;
+        uint64_t last_in_block = (block + 1) * ZONE_MAP_BLOCK_SIZE - 1;
+
+        // blocks with rows the zone maps do not cover may always match
+        bool may_match = true;
+        bool covered = std::min<uint64_t>(last_in_block + 1, tuples.size()) <= zone_mapped_rows;
+        for(auto& predicate : predicates) {
+            if(covered && predicate.index < zone_maps.size() && block < zone_maps[predicate.index].size() && !predicate.may_match(zone_maps[predicate.index][block])) {
+                may_match = false;
+                break;
+            }
+        }
+
+        if(may_match) {
+            selection.clear();
+            while(current.has_value() && current.value() <= last_in_block) {
+                selection.push_back(current.value());
+                current = bitset.succ(current.value());
+            }
+
+            // narrow down the selection one predicate at a time, branch free so the loop stays tight
+            for(auto& predicate : predicates) {
+                uint64_t selected = 0;
+                for(auto row_id : selection) {
+                    selection[selected] = row_id;
+                    selected += predicate.matches(row(row_id)[predicate.index]);
+                }
+                selection.resize(selected);
+            }
+
+            result.insert(result.end(), selection.begin(), selection.end());
+        } else {
+            // there are no rows after the last block
+            if(last_in_block + 1 >= tuples.size()) break;
+            current = bitset.succ(last_in_block);
+        }
+    }
+
+    return result;
+}
+
+ColumnarSnapshot TemporalTable::get_columns(const checkpoint& bitset, const std::vector<uint16_t>& projection, const std::vector<Predicate>& predicates) const {
+    ColumnarSnapshot result{projection, select_rows(bitset, predicates), {}};
+
+    // live rows are never reclaimed, so the first one tells the number of columns
+    if(!result.row_ids.empty()) {
+        uint64_t columns = row(result.row_ids[0]).size();
+        for(auto index : projection) {
+            if(index >= columns) throw std::invalid_argument("Column does not exist");
+        }
     }
 
+    result.columns.assign(projection.size(), std::vector<uint64_t>(result.row_ids.size()));
+    std::vector<uint64_t*> outputs;
+    for(auto& column : result.columns) {
+        outputs.push_back(column.data());
+    }
+
+    // row at a time, every tuple is its own allocation and should only be visited once
+    for(uint64_t position = 0; position < result.row_ids.size(); ++position) {
+        const uint64_t* values = row(result.row_ids[position]).data();
+        for(uint64_t i = 0; i < projection.size(); ++i) {
+            outputs[i][position] = values[projection[i]];
+        }
+    }
+
+    return result;
+}
+
+ZoneMap TemporalTable::column_range(uint16_t index) const {
+    ZoneMap result{UINT64_MAX, 0};
+    if(index < zone_maps.size() && zone_mapped_rows == tuples.size()) {
+        for(auto& zone_map : zone_maps[index]) {
+            result.min = std::min(result.min, zone_map.min);
+            result.max = std::max(result.max, zone_map.max);
+        }
+        return result;
+    }
+
+    for(row_id_type row_id = 0; row_id < tuples.size(); ++row_id) {
+        auto values = row(row_id);
+        // reclaimed row
+        if(values.empty()) continue;
+        result.min = std::min(result.min, values[index]);
+        result.max = std::max(result.max, values[index]);
+    }
+    return result;
+}
+
+void TemporalTable::build_zone_maps() {
+    zone_maps.clear();
+    zone_mapped_rows = 0;
+    if(tuples.empty()) return;
+
+    uint64_t columns = row(0).size();
+    uint64_t blocks = (tuples.size() + ZONE_MAP_BLOCK_SIZE - 1) / ZONE_MAP_BLOCK_SIZE;
+    zone_maps.assign(columns, std::vector<ZoneMap>(blocks, ZoneMap{UINT64_MAX, 0}));
+
+    for(uint64_t row_id = 0; row_id < tuples.size(); ++row_id) {
+        auto tuple = row(row_id);
+        // reclaimed row
+        if(tuple.empty()) continue;
+        uint64_t block = row_id / ZONE_MAP_BLOCK_SIZE;
+        for(uint64_t column = 0; column < columns; ++column) {
+            auto& zone_map = zone_maps[column][block];
+            zone_map.min = std::min(zone_map.min, tuple[column]);
+            zone_map.max = std::max(zone_map.max, tuple[column]);
+        }
+    }
+    zone_mapped_rows = tuples.size();
+}
+
+void TemporalTable::extend_zone_maps(uint64_t row_id) {
+    // only rows right behind the covered ones extend the zone maps, otherwise their blocks stay uncovered
+    if(zone_maps.empty() || row_id != zone_mapped_rows) return;
+    auto values = row(row_id);
+    if(values.size() != zone_maps.size()) return;
+
+    uint64_t block = row_id / ZONE_MAP_BLOCK_SIZE;
+    for(uint64_t column = 0; column < zone_maps.size(); ++column) {
+        if(block == zone_maps[column].size()) zone_maps[column].push_back(ZoneMap{UINT64_MAX, 0});
+        auto& zone_map = zone_maps[column][block];
+        zone_map.min = std::min(zone_map.min, values[column]);
+        zone_map.max = std::max(zone_map.max, values[column]);
+    }
+    ++zone_mapped_rows;
+}
+
+void TemporalTable::append_row(std::span<const uint64_t> values, LifeSpan lifespan) {
+    if(row_width == 0) {
+        tuples.emplace_back(Tuple(values.begin(), values.end()), lifespan);
+    } else {
+        if(values.size() != row_width) throw std::invalid_argument("Row does not match the row width");
+        arena.insert(arena.end(), values.begin(), values.end());
+        tuples.emplace_back(Tuple(), lifespan);
+    }
+    extend_zone_maps(tuples.size() - 1);
+}
+
+void TemporalTable::pack_rows() {
+    if(row_width != 0 || tuples.empty()) return;
+
+    uint64_t width = 0;
+    for(auto& [tuple, _] : tuples) {
+        if(tuple.empty()) continue;
+        if(width != 0 && tuple.size() != width) throw std::invalid_argument("Rows have different widths");
+        width = tuple.size();
+    }
+    if(width == 0) return;
+
+    arena.assign(tuples.size() * width, 0);
+    for(uint64_t row_id = 0; row_id < tuples.size(); ++row_id) {
+        auto& tuple = tuples[row_id].first;
+        std::copy(tuple.begin(), tuple.end(), arena.begin() + row_id * width);
+        Tuple().swap(tuple);
+    }
+    row_width = width;
+}
+
+uint64_t TemporalTable::reclaim_rows(version reclaimed_version) {
+    uint64_t result = 0;
+    if(row_width != 0) return result;
+    for(auto& [tuple, lifespan] : tuples) {
+        if(lifespan.end.has_value() && lifespan.end.value() <= reclaimed_version && !tuple.empty()) {
+            Tuple().swap(tuple);
+            ++result;
+        }
+    }
     return result;
 }
 
-uint64_t TemporalTable::get_number_of_events() {
+uint64_t TemporalTable::get_number_of_events() const {
     // iterate over all tuples and add the number of events
     uint64_t result = 0;
     for(auto& [_, lifespan] : tuples) {
@@ -36,3 +277,19 @@ uint64_t TemporalTable::get_number_of_events() {
     }
     return result;
 }
+
+TableMemoryUsage TemporalTable::memory_usage() const {
+    uint64_t rows = arena.capacity() * sizeof(uint64_t);
+    for(auto& [tuple, _] : tuples) {
+        rows += tuple.capacity() * sizeof(uint64_t);
+    }
+    uint64_t zone_map_bytes = zone_maps.capacity() * sizeof(zone_maps[0]);
+    for(auto& column : zone_maps) {
+        zone_map_bytes += column.capacity() * sizeof(ZoneMap);
+    }
+    uint64_t typed_column_bytes = 0;
+    for(auto& column : typed_columns) {
+        typed_column_bytes += std::visit([](const auto& values) {return values.capacity() * sizeof(values[0]);}, column);
+    }
+    return {tuples.capacity() * sizeof(tuples[0]), rows, zone_map_bytes, typed_column_bytes};
+}
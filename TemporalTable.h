@@ -6,7 +6,10 @@
 #include <vector>
 #include <span>
 #include <optional>
+#include <type_traits>
+#include <variant>
 #include "Tree.h"
+#include "IndexTypes.h"
 
 #ifndef TIMELINEINDEX_TEMPORALTABLE_H
 #define TIMELINEINDEX_TEMPORALTABLE_H
@@ -18,12 +21,116 @@
  * @details This class represents a tuple from the Temporal Table, which is a vector of spans
  */
 typedef std::vector<uint64_t> Tuple;
-typedef Tree<uint32_t, 16> checkpoint;
+
+// a checkpoint holds the row ids below 2^CHECKPOINT_BITS in both id widths, larger tables have to be sharded
+inline constexpr unsigned CHECKPOINT_BITS = 16;
+typedef Tree<uint32_t, CHECKPOINT_BITS> checkpoint;
 
 struct LifeSpan {
-    uint32_t start;
+    version start;
     // tuple might not have been deleted, then this value is None
-    std::optional<uint32_t> end;
+    std::optional<version> end;
+};
+
+/**
+ * @brief Type of a typed column, in the order of the alternatives of TypedColumn
+ */
+enum class ColumnType {
+    U8,
+    U16,
+    U32,
+    U64,
+    I64,
+    F32,
+    F64
+};
+
+/**
+ * @brief Values of one typed column, one entry per row id
+ */
+typedef std::variant<std::vector<uint8_t>, std::vector<uint16_t>, std::vector<uint32_t>, std::vector<uint64_t>,
+                     std::vector<int64_t>, std::vector<float>, std::vector<double>> TypedColumn;
+
+/**
+ * @brief Type used to aggregate values of type T, unsigned integers use uint64_t, signed int64_t and floating points double
+ */
+template<typename T>
+using AccumulatorType = std::conditional_t<std::is_floating_point_v<T>, double, std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>>;
+
+/**
+ * @brief Per version result of an aggregate over a typed column, holds the AccumulatorType of the column
+ */
+typedef std::variant<std::vector<uint64_t>, std::vector<int64_t>, std::vector<double>> TypedSeries;
+
+/**
+ * @brief Minimum and maximum value of one column inside a block of rows
+ */
+struct ZoneMap {
+    uint64_t min;
+    uint64_t max;
+};
+
+enum class Comparison {
+    LESS,
+    LESS_EQUAL,
+    EQUAL,
+    GREATER_EQUAL,
+    GREATER
+};
+
+/**
+ * @brief Simple column predicate of the form tuple[index] <comparison> value
+ */
+struct Predicate {
+    uint16_t index;
+    Comparison comparison;
+    uint64_t value;
+
+    bool matches(uint64_t column_value) const {
+        switch(comparison) {
+            case Comparison::LESS: return column_value < value;
+            case Comparison::LESS_EQUAL: return column_value <= value;
+            case Comparison::EQUAL: return column_value == value;
+            case Comparison::GREATER_EQUAL: return column_value >= value;
+            case Comparison::GREATER: return column_value > value;
+        }
+        return false;
+    }
+
+    // false if no value inside the zone map can satisfy the predicate
+    bool may_match(const ZoneMap& zone_map) const {
+        switch(comparison) {
+            case Comparison::LESS: return zone_map.min < value;
+            case Comparison::LESS_EQUAL: return zone_map.min <= value;
+            case Comparison::EQUAL: return zone_map.min <= value && value <= zone_map.max;
+            case Comparison::GREATER_EQUAL: return zone_map.max >= value;
+            case Comparison::GREATER: return zone_map.max > value;
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Bytes allocated by a TemporalTable
+ * @details tuples is the vector of (Tuple, LifeSpan) pairs itself, rows are the heap allocations of the single tuples
+ * or the arena
+ */
+struct TableMemoryUsage {
+    uint64_t tuples;
+    uint64_t rows;
+    uint64_t zone_maps;
+    uint64_t typed_columns;
+};
+
+/**
+ * @brief Projected snapshot in columnar layout
+ * @details columns[i] holds the values of the column projection[i], row_ids the row id behind every position.
+ * All vectors have one entry per live row, ordered by row id.
+ */
+struct ColumnarSnapshot {
+    std::vector<uint16_t> projection;
+    std::vector<row_id_type> row_ids;
+    std::vector<std::vector<uint64_t>> columns;
 };
 
 /**
@@ -32,7 +139,7 @@ struct LifeSpan {
  */
 class TemporalTable {
 public:
-    uint32_t next_version;
+    version next_version;
 
 
     /**
@@ -42,29 +149,163 @@ public:
      */
     std::vector<std::pair<Tuple, LifeSpan>> tuples;
 
-    TemporalTable(uint32_t version_number, uint64_t tuples_size);
+    /**
+     * @brief Row arena
+     * @details if row_width is not 0 the values of all rows are stored here back to back, row i at i * row_width.
+     * The tuples then only hold the lifespans and their Tuple stays empty, see append_row and pack_rows.
+     * The empty Tuple still costs its vector header of 24 bytes per row next to the lifespan, the arena saves the
+     * heap allocation of every row but not this header, as the lifespans stay in tuples for all readers of the table.
+     * TableMemoryUsage::tuples counts these headers
+     */
+    uint16_t row_width = 0;
+    std::vector<uint64_t> arena;
 
-    uint64_t get_table_size();
+    /**
+     * @brief Typed columns
+     * @details narrow attributes stored next to the rows in their own type, one value per row id.
+     * They are aggregated with the *_typed functions of the TimelineIndex
+     */
+    std::vector<TypedColumn> typed_columns;
+
+    /**
+     * @brief Zone maps
+     * @details zone_maps[column][block] holds the minimum and maximum value of the column
+     * inside the block of ZONE_MAP_BLOCK_SIZE row ids. They cover the first zone_mapped_rows rows, append_row extends
+     * them, rows added to the tuples directly are not covered and their blocks are never skipped
+     */
+    std::vector<std::vector<ZoneMap>> zone_maps;
+    uint64_t zone_mapped_rows = 0;
+
+    TemporalTable(version version_number, uint64_t tuples_size);
+
+    /**
+     * @brief Creates an empty table that stores its rows in the arena with the given number of columns
+     */
+    TemporalTable(version version_number, uint64_t tuples_size, uint16_t row_width);
+
+    uint64_t get_table_size() const;
+
+    /**
+     * @brief Returns whether the rows of the table have a column with the given index
+     * @details also true for tables without a readable row, as no row would be read
+     */
+    bool has_column(uint16_t index) const;
+
+    /**
+     * @brief Returns the values of a row, independent of the row storage. Reclaimed rows are empty
+     */
+    std::span<const uint64_t> row(row_id_type row_id) const {
+        if(row_width != 0) return {arena.data() + static_cast<uint64_t>(row_id) * row_width, row_width};
+        return tuples[row_id].first;
+    }
+
+    /**
+     * @brief Appends a row to the table, to the arena if the table has one
+     * @details throws std::invalid_argument if the row does not have row_width values
+     */
+    void append_row(std::span<const uint64_t> values, LifeSpan lifespan);
+
+    /**
+     * @brief Moves the values of all rows into the arena and frees the single tuples
+     * @details all rows must have the same number of columns, reclaimed rows are filled with zeros.
+     * Rows of an arena are never reclaimed, see reclaim_rows
+     */
+    void pack_rows();
 
     /**
      * @brief Returns all tuples that are alive at the given version
      * @param bitset
      * @return
      */
-    std::vector<Tuple> get_tuples(checkpoint& bitset);
+    std::vector<Tuple> get_tuples(const checkpoint& bitset) const;
+
+    /**
+     * @brief Returns all tuples alive at the given version that satisfy all predicates
+     * @details blocks of rows whose zone maps rule out a predicate are skipped without touching their rows
+     * @param bitset
+     * @param predicates
+     * @return
+     */
+    std::vector<Tuple> get_tuples(const checkpoint& bitset, const std::vector<Predicate>& predicates) const;
+
+    /**
+     * @brief Adds a typed column holding one value for every row of the table
+     * @details throws std::invalid_argument if the column does not have one value per row
+     * @return index of the typed column
+     */
+    uint16_t add_typed_column(TypedColumn column);
+
+    /**
+     * @brief Returns a typed column, throws std::invalid_argument if it does not exist or does not cover all rows
+     */
+    const TypedColumn& get_typed_column(uint16_t typed_column) const;
+
+    ColumnType get_column_type(uint16_t typed_column) const;
+
+    /**
+     * @brief Returns the ids of all rows alive at the given version that satisfy all predicates
+     * @details same block skipping as get_tuples, but only the predicate columns of the rows are read
+     * @param bitset
+     * @param predicates
+     * @return
+     */
+    std::vector<row_id_type> select_rows(const checkpoint& bitset, const std::vector<Predicate>& predicates) const;
+
+    /**
+     * @brief Returns the projected columns of the rows alive at the given version that satisfy all predicates
+     * @details the rows are selected first, afterwards only the projected columns of the selected rows are copied
+     * @param bitset
+     * @param projection column indices, throws std::invalid_argument if one is out of range
+     * @param predicates
+     * @return
+     */
+    ColumnarSnapshot get_columns(const checkpoint& bitset, const std::vector<uint16_t>& projection, const std::vector<Predicate>& predicates) const;
+
+    /**
+     * @brief Returns the smallest and largest value of a column over all rows
+     * @details answered from the zone maps if they cover all rows, otherwise by a pass over the rows.
+     * min is larger than max if the table has no rows
+     */
+    ZoneMap column_range(uint16_t index) const;
+
+    /**
+     * @brief (Re)computes the zone maps of all columns over the current tuples
+     */
+    void build_zone_maps();
+
+    // adds a row appended right behind the covered rows to the zone maps, see zone_maps
+    void extend_zone_maps(uint64_t row_id);
+
+    /**
+     * @brief Frees the tuples of all rows deleted at or before the given version
+     * @details row ids stay stable, the reclaimed rows are left with an empty tuple.
+     * Rows in the arena cannot be freed one by one, for tables with an arena nothing is reclaimed
+     * @return number of reclaimed rows
+     */
+    uint64_t reclaim_rows(version reclaimed_version);
 
     /**
      *
      * @return number of events in the table
      */
-    uint64_t get_number_of_events();
+    uint64_t get_number_of_events() const;
+
+    /**
+     * @brief Returns the memory used by the table, requires one pass over the rows
+     */
+    TableMemoryUsage memory_usage() const;
 
 
     // extremely naive approaches, just for testing
-    std::vector<Tuple> time_travel(uint32_t query_version);
-    std::vector<uint64_t> temporal_sum(uint16_t index);
-    std::vector<uint64_t> temporal_max(uint16_t index);
-    TemporalTable temporal_join(TemporalTable& other, uint16_t index);
+    std::vector<Tuple> time_travel(version query_version) const;
+    std::vector<uint64_t> temporal_sum(uint16_t index) const;
+    std::vector<uint64_t> temporal_max(uint16_t index) const;
+    std::vector<uint64_t> temporal_count_distinct(uint16_t index) const;
+    std::vector<std::vector<uint64_t>> temporal_quantiles(uint16_t index, const std::vector<double>& quantiles) const;
+    std::vector<std::vector<row_id_type>> temporal_top_k(uint16_t index, uint32_t k) const;
+    TemporalTable temporal_join(const TemporalTable& other, uint16_t index) const;
+    TypedSeries temporal_sum_typed(uint16_t typed_column) const;
+    TypedSeries temporal_max_typed(uint16_t typed_column) const;
 
 };
 
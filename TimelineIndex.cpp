@@ -7,6 +7,9 @@
 #include "Tree.h"
 #include <set>
 #include <thread>
+#include <chrono>
+#include <numeric>
+#include <cmath>
 
 #define CHECKPOINT_AMOUNT 50
 #define TOP_K 100
@@ -14,13 +17,25 @@
 
 
 TimelineIndex::TimelineIndex(TemporalTable& given_table) : table(given_table), temporal_table_size(given_table.get_table_size()), joined_table(given_table) {
+    if(temporal_table_size > (1ull << CHECKPOINT_BITS)) throw std::invalid_argument("Table has more rows than a checkpoint holds");
     version_map = VersionMap(given_table);
+    build_checkpoints();
+}
+
+TimelineIndex::TimelineIndex(TemporalTable& given_table, const std::vector<event_offset>& version_histogram) : table(given_table), joined_table(given_table), temporal_table_size(given_table.get_table_size()) {
+    if(temporal_table_size > (1ull << CHECKPOINT_BITS)) throw std::invalid_argument("Table has more rows than a checkpoint holds");
+    version_map = VersionMap(given_table, version_histogram);
+    build_checkpoints();
+}
+
+void TimelineIndex::build_checkpoints() {
+    table.build_zone_maps();
 
     // for now checkpoints we will create 100 checkpoints
-    uint32_t step_size = std::max(given_table.next_version / CHECKPOINT_AMOUNT, 1u);
+    version step_size = std::max<version>(table.next_version / CHECKPOINT_AMOUNT, 1);
     checkpoint current_bitset;
 
-    for(int i=0; i<given_table.next_version; i++) {
+    for(version i=0; i<table.next_version; i++) {
         auto events = version_map.get_events(i);
         for(auto& event : events) {
             if(event.type == EventType::INSERT) {
@@ -30,7 +45,7 @@ TimelineIndex::TimelineIndex(TemporalTable& given_table) : table(given_table), t
             }
         }
         if(i % step_size == 0) {
-            checkpoints.emplace_back(i, std::move(current_bitset));
+            checkpoints.emplace_back(i, current_bitset);
         }
     }
 
@@ -39,11 +54,26 @@ TimelineIndex::TimelineIndex(TemporalTable& given_table) : table(given_table), t
 TimelineIndex::TimelineIndex(TemporalTable& given_table, TemporalTable& given_joined_table) : table(given_table), joined_table(given_joined_table), temporal_table_size(joined_table.get_table_size()), version_map() {}
 
 void TimelineIndex::append_version(std::vector<Event>& events) {
+    for(auto& event : events) {
+        if(event.row_id >= table.get_table_size()) throw std::invalid_argument("Row does not exist");
+        // rows appended to the table after the construction
+        if(event.row_id >= (1ull << CHECKPOINT_BITS)) throw std::invalid_argument("Row does not fit into a checkpoint");
+    }
+    std::lock_guard maintenance(lock.maintenance);
+    std::unique_lock queries(lock.queries);
     version_map.register_version(events);
+    for(auto& aggregate : materialized_aggregates) {
+        aggregate.append(events, table);
+    }
+}
+
+version TimelineIndex::get_current_version() const {
+    std::shared_lock queries(lock.queries);
+    return version_map.current_version;
 }
 
 
-std::pair<version, checkpoint> TimelineIndex::find_nearest_checkpoint(version query_version) {
+std::pair<version, checkpoint> TimelineIndex::find_nearest_checkpoint(version query_version) const {
     if(checkpoints.empty()) {
         // used for joined index
         return {0, checkpoint()};
@@ -52,32 +82,45 @@ std::pair<version, checkpoint> TimelineIndex::find_nearest_checkpoint(version qu
         throw std::invalid_argument("Version does not exist");
     }
 
-    std::pair search_val{query_version, Tree<uint32_t, 32>()};
-
-    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), search_val,
-        [](auto x, auto y) -> bool {return x.first < y.first;});
+    // compare versions only, the checkpoints must not be copied during the search
+    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), query_version,
+        [](version x, const auto& y) -> bool {return x < y.first;});
 
 
 
-    if(it != checkpoints.end()) {
-        int version1 = it->first;
-        int version2 = (it-1)->first;
-        if(version1 - query_version < query_version - version2) {
-            return *it;
-        } else {
-            return *(it-1);
+    if(it == checkpoints.end()) {
+        --it;
+    } else {
+        version version1 = it->first;
+        version version2 = (it-1)->first;
+        if(version1 - query_version >= query_version - version2) {
+            --it;
         }
     }
 
-    --it;
+    // a cached snapshot replaces the checkpoint if it is closer to the query version
+    version distance = it->first > query_version ? it->first - query_version : query_version - it->first;
+    if(distance > 0) {
+        auto cached_snapshot = snapshot_cache.find_nearest(query_version, distance);
+        if(cached_snapshot.has_value()) return std::move(cached_snapshot.value());
+    }
+
     return *it;
 }
 
-std::vector<Tuple> TimelineIndex::time_travel(uint32_t version) {
-    auto [nearest_checkpoint_version, bitset] = find_nearest_checkpoint(version);
-
-    if(nearest_checkpoint_version <= version) {
-        auto events = version_map.get_events(nearest_checkpoint_version + 1, version + 1);
+checkpoint TimelineIndex::reconstruct(version query_version, bool cache_snapshot) const {
+#ifdef STATISTICS
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t events_applied;
+#endif
+    auto [nearest_checkpoint_version, bitset] = find_nearest_checkpoint(query_version);
+    std::vector<Event> buffer;
+
+    if(nearest_checkpoint_version <= query_version) {
+        auto events = version_map.get_events(nearest_checkpoint_version + 1, query_version + 1, buffer);
+#ifdef STATISTICS
+        events_applied = events.size();
+#endif
         for(auto& event : events) {
             if(event.type == EventType::INSERT) {
                 bitset.insert(event.row_id);
@@ -86,7 +129,10 @@ std::vector<Tuple> TimelineIndex::time_travel(uint32_t version) {
             }
         }
     } else {
-        auto events = version_map.get_events(version+1, nearest_checkpoint_version + 1);
+        auto events = version_map.get_events(query_version+1, nearest_checkpoint_version + 1, buffer);
+#ifdef STATISTICS
+        events_applied = events.size();
+#endif
         auto event = events.rbegin();
         for(; event != events.rend(); ++event) {
             if(event->type == EventType::DELETE) {
@@ -97,62 +143,325 @@ std::vector<Tuple> TimelineIndex::time_travel(uint32_t version) {
         }
     }
 
+    if(cache_snapshot && nearest_checkpoint_version != query_version) {
+        snapshot_cache.insert(query_version, bitset);
+    }
+
+#ifdef STATISTICS
+    auto end = std::chrono::high_resolution_clock::now();
+    statistics.record_time_travel(TimeTravelRecord{query_version, nearest_checkpoint_version, nearest_checkpoint_version <= query_version, events_applied,
+                                                   static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end-start).count())});
+#endif
+    return std::move(bitset);
+}
+
+std::vector<Tuple> TimelineIndex::time_travel(version query_version) const {
+    std::shared_lock queries(lock.queries);
+    auto bitset = reconstruct(query_version, true);
     return table.get_tuples(bitset);
 }
 
+version TimelineIndex::checkpoint_distance(version query_version) const {
+    if(checkpoints.empty()) return query_version;
 
-void TimelineIndex::threading_sum(uint32_t starting_version, uint32_t ending_version, uint16_t index, std::vector<uint64_t>& sum) {
-    auto activated_tuples = time_travel(starting_version);
-    uint64_t current_sum = 0;
-    for(auto& tuples : activated_tuples) {
-        current_sum += tuples[index];
-    }
-    sum[starting_version] = current_sum;
+    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), query_version,
+        [](version x, const auto& y) -> bool {return x < y.first;});
+    if(it == checkpoints.begin()) return 0;
 
-    for(int i=starting_version+1; i<ending_version; i++) {
-        auto events = version_map.get_events(i);
-        for(auto& event : events) {
-            if(event.type == EventType::INSERT) {
-                current_sum += table.tuples[event.row_id].first[index];
-            } else if(event.type == EventType::DELETE) {
-                current_sum -= table.tuples[event.row_id].first[index];
+    version distance = query_version - (it-1)->first;
+    if(it != checkpoints.end()) distance = std::min(distance, it->first - query_version);
+    return distance;
+}
+
+std::vector<std::vector<Tuple>> TimelineIndex::time_travel_batch(const std::vector<version>& query_versions) const {
+    std::shared_lock queries(lock.queries);
+    std::vector<std::vector<Tuple>> result(query_versions.size());
+
+    std::vector<uint32_t> order(query_versions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {return query_versions[a] < query_versions[b];});
+
+    std::optional<checkpoint> bitset;
+    version current_version = 0;
+    std::vector<Event> buffer;
+
+    for(auto position : order) {
+        version query_version = query_versions[position];
+
+        if(bitset.has_value() && query_version - current_version <= checkpoint_distance(query_version)) {
+            auto events = version_map.get_events(current_version + 1, query_version + 1, buffer);
+            for(auto& event : events) {
+                if(event.type == EventType::INSERT) {
+                    bitset->insert(event.row_id);
+                } else if(event.type == EventType::DELETE) {
+                    bitset->remove(event.row_id);
+                }
             }
+        } else {
+            bitset = reconstruct(query_version, true);
+        }
+
+        current_version = query_version;
+        result[position] = table.get_tuples(bitset.value());
+    }
+
+    return result;
+}
+
+std::vector<Tuple> TimelineIndex::time_travel_filtered(version query_version, const std::vector<Predicate>& predicates) const {
+    std::shared_lock queries(lock.queries);
+    auto bitset = reconstruct(query_version, true);
+    return table.get_tuples(bitset, predicates);
+}
+
+ColumnarSnapshot TimelineIndex::time_travel_projected(version query_version, const std::vector<uint16_t>& projection,
+                                                      const std::vector<Predicate>& predicates) const {
+    std::shared_lock queries(lock.queries);
+    auto bitset = reconstruct(query_version, true);
+    return table.get_columns(bitset, projection, predicates);
+}
+
+VersionDiff TimelineIndex::diff(version from_version, version to_version) const {
+    std::shared_lock queries(lock.queries);
+    if(from_version > to_version) {
+        auto result = diff_events(to_version, from_version);
+        std::swap(result.inserted, result.deleted);
+        return result;
+    }
+    return diff_events(from_version, to_version);
+}
+
+VersionDiff TimelineIndex::diff_events(version from_version, version to_version) const {
+    if(from_version < version_map.base_version || to_version >= version_map.current_version) {
+        throw std::invalid_argument("Version does not exist");
+    }
+
+    VersionDiff result;
+    std::vector<Event> buffer;
+    for(auto& event : version_map.get_events(from_version + 1, to_version + 1, buffer)) {
+        if(event.type == EventType::INSERT) {
+            result.inserted.push_back(event.row_id);
+        } else if(event.type == EventType::DELETE) {
+            result.deleted.push_back(event.row_id);
         }
-        sum[i] = current_sum;
     }
+
+    // a row is inserted and deleted at most once, rows in both lists were inserted and deleted in the range
+    std::sort(result.inserted.begin(), result.inserted.end());
+    std::sort(result.deleted.begin(), result.deleted.end());
+    std::vector<row_id_type> inserted;
+    std::vector<row_id_type> deleted;
+    std::set_difference(result.inserted.begin(), result.inserted.end(), result.deleted.begin(), result.deleted.end(), std::back_inserter(inserted));
+    std::set_difference(result.deleted.begin(), result.deleted.end(), result.inserted.begin(), result.inserted.end(), std::back_inserter(deleted));
+
+    return {std::move(inserted), std::move(deleted)};
 }
 
+ExportPosition TimelineIndex::export_events(ExportPosition position, version end_version, const std::vector<uint16_t>& projection,
+                                            uint64_t batch_size, EventBatch& batch) const {
+    std::shared_lock queries(lock.queries);
+    if(position.version_number < version_map.base_version) throw std::invalid_argument("Version does not exist");
+    // checked before anything is added, so the columns of the batch keep the same length
+    for(auto index : projection) {
+        if(!table.has_column(index)) throw std::invalid_argument("Column does not exist");
+    }
+    end_version = std::min<uint64_t>(end_version, version_map.current_version);
+    batch.columns.resize(projection.size());
+    // recycled batches keep their capacity, so this only allocates for fresh batches
+    batch.versions.reserve(batch_size);
+    batch.row_ids.reserve(batch_size);
+    batch.types.reserve(batch_size);
+    for(auto& column : batch.columns) column.reserve(batch_size);
+
+    std::vector<Event> buffer;
+    while(position.version_number < end_version && batch.length < batch_size) {
+        auto events = version_map.get_events(position.version_number, position.version_number + 1, buffer);
+        uint64_t amount = std::min(events.size() - position.event, batch_size - batch.length);
+        auto exported = events.subspan(position.event, amount);
+
+        batch.versions.insert(batch.versions.end(), amount, position.version_number);
+        // row at a time, so every row of an event is only looked up once
+        for(auto& event : exported) {
+            batch.row_ids.push_back(event.row_id);
+            batch.types.push_back(event.type == EventType::DELETE);
+            const uint64_t* values = table.row(event.row_id).data();
+            for(uint64_t i=0; i<projection.size(); i++) {
+                batch.columns[i].push_back(values[projection[i]]);
+            }
+        }
+        batch.length += amount;
+
+        position.event += amount;
+        if(position.event == events.size()) {
+            position = {position.version_number + 1, 0};
+        }
+    }
+
+    return position;
+}
 
-std::vector<uint64_t> TimelineIndex::temporal_sum(uint16_t index) {
-    std::vector<uint64_t> result(version_map.current_version, 0);
 
+template<typename Kernel>
+void TimelineIndex::run_partitioned(Kernel kernel) const {
     std::vector<std::thread> threads;
-    std::vector<ThreadSum> args;
 
-    uint32_t step_size = version_map.current_version / THREAD_AMOUNT;
+    version step_size = (version_map.current_version - version_map.base_version) / THREAD_AMOUNT;
 
     for(uint32_t i=0; i<THREAD_AMOUNT; i++) {
-        uint32_t starting_version = i * step_size;
-        uint32_t ending_version = (i+1) * step_size;
+        version starting_version = version_map.base_version + i * step_size;
+        version ending_version = version_map.base_version + (i+1) * step_size;
         if(i == THREAD_AMOUNT-1) ending_version = version_map.current_version;
-        args.emplace_back(ThreadSum{result, starting_version, ending_version, index});
-        std::thread thread(&TimelineIndex::threading_sum, this, starting_version, ending_version, index, std::ref(result));
-        threads.push_back(std::move(thread));
+        // threads without versions would reconstruct a version that does not exist
+        if(starting_version >= ending_version) continue;
+        threads.emplace_back(kernel, i, starting_version, ending_version);
     }
 
     for(auto& thread : threads) {
         thread.join();
     }
+}
+
+template<typename Result, typename Kernel>
+std::vector<Result> TimelineIndex::partition_versions(Kernel kernel) const {
+    // dropped versions stay 0
+    std::vector<Result> result(version_map.current_version, 0);
+    run_partitioned([&](uint32_t, version starting_version, version ending_version) {
+        kernel(starting_version, ending_version, result);
+    });
+    return result;
+}
+
+/**
+ * @brief Folds the values of ascending versions into buckets of bucket_width versions
+ * @details a writer only sees the versions of one thread, the threads get whole buckets so no bucket is shared
+ */
+struct RollupWriter {
+    std::vector<RollupBucket>& buckets;
+    version bucket_width;
+    double total = 0;
+    uint64_t stored = 0;
+
+    void operator()(version version_number, uint64_t value) {
+        auto& bucket = buckets[version_number / bucket_width];
+        if(stored == 0) {
+            bucket.min = value;
+            bucket.max = value;
+            total = 0;
+        }
+        bucket.min = std::min(bucket.min, value);
+        bucket.max = std::max(bucket.max, value);
+        bucket.last = value;
+        total += value;
+        bucket.avg = total / ++stored;
+        if((version_number + 1) % bucket_width == 0) stored = 0;
+    }
+};
+
+template<typename Kernel>
+std::vector<RollupBucket> TimelineIndex::partition_buckets(version bucket_width, Kernel kernel) const {
+    if(bucket_width == 0) throw std::invalid_argument("Bucket width must be larger than 0");
+    version current_version = version_map.current_version;
+    // wider buckets hold all versions just as well and keep the version numbers below from overflowing
+    bucket_width = std::min(bucket_width, std::max<version>(current_version, 1));
+    std::vector<RollupBucket> result(current_version / bucket_width + (current_version % bucket_width != 0), RollupBucket{});
+
+    std::vector<std::thread> threads;
+
+    // buckets of dropped versions stay 0, the first bucket may start after its first version
+    uint64_t first_bucket = version_map.base_version / bucket_width;
+    uint64_t bucket_amount = result.size() - first_bucket;
+
+    for(uint32_t i=0; i<THREAD_AMOUNT; i++) {
+        version starting_version = std::max<uint64_t>(version_map.base_version, (first_bucket + bucket_amount * i / THREAD_AMOUNT) * bucket_width);
+        version ending_version = std::min<uint64_t>(current_version, (first_bucket + bucket_amount * (i+1) / THREAD_AMOUNT) * bucket_width);
+        // fewer buckets than threads
+        if(starting_version >= ending_version) continue;
+        threads.emplace_back(kernel, starting_version, ending_version, RollupWriter{result, bucket_width});
+    }
 
+    for(auto& thread : threads) {
+        thread.join();
+    }
 
     return result;
 }
 
-uint64_t get_max_element(const std::multiset<uint64_t, std::greater<>>& max_set) {
+template<typename Accumulator, typename Values, typename Store>
+void TimelineIndex::replay_sum(version starting_version, version ending_version, Values values, Store store) const {
+#ifdef STATISTICS
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t events_applied = 0;
+#endif
+    auto bitset = reconstruct(starting_version);
+    Accumulator current_sum = 0;
+    for(auto row_id : table.select_rows(bitset, {})) {
+        current_sum += values(row_id);
+    }
+    store(starting_version, current_sum);
+
+    std::vector<Event> buffer;
+    for(version i=starting_version+1; i<ending_version; i++) {
+        auto events = version_map.get_events(i, i+1, buffer);
+#ifdef STATISTICS
+        events_applied += events.size();
+#endif
+        for(auto& event : events) {
+            if(event.type == EventType::INSERT) {
+                current_sum += values(event.row_id);
+            } else if(event.type == EventType::DELETE) {
+                current_sum -= values(event.row_id);
+            }
+        }
+        store(i, current_sum);
+    }
+
+#ifdef STATISTICS
+    auto end = std::chrono::high_resolution_clock::now();
+    statistics.record_thread(ThreadRecord{"sum", starting_version, ending_version, events_applied, 0,
+                                          static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end-start).count())});
+#endif
+}
+
+void TimelineIndex::threading_sum(version starting_version, version ending_version, uint16_t index, std::vector<uint64_t>& sum) const {
+    replay_sum<uint64_t>(starting_version, ending_version, [&](row_id_type row_id) {return table.row(row_id)[index];},
+                         [&](version version_number, uint64_t value) {sum[version_number] = value;});
+}
+
+
+std::vector<uint64_t> TimelineIndex::temporal_sum(uint16_t index) const {
+    std::shared_lock queries(lock.queries);
+    if(!table.has_column(index)) throw std::invalid_argument("Column does not exist");
+    return partition_versions<uint64_t>([&](version starting_version, version ending_version, std::vector<uint64_t>& sum) {
+        threading_sum(starting_version, ending_version, index, sum);
+    });
+}
+
+std::vector<RollupBucket> TimelineIndex::temporal_sum_rollup(uint16_t index, version bucket_width) const {
+    std::shared_lock queries(lock.queries);
+    if(!table.has_column(index)) throw std::invalid_argument("Column does not exist");
+    return partition_buckets(bucket_width, [&](version starting_version, version ending_version, RollupWriter writer) {
+        replay_sum<uint64_t>(starting_version, ending_version, [&](row_id_type row_id) {return table.row(row_id)[index];}, writer);
+    });
+}
+
+TypedSeries TimelineIndex::temporal_sum_typed(uint16_t typed_column) const {
+    std::shared_lock queries(lock.queries);
+    return std::visit([&](const auto& column) -> TypedSeries {
+        using Accumulator = AccumulatorType<typename std::decay_t<decltype(column)>::value_type>;
+        return partition_versions<Accumulator>([&](version starting_version, version ending_version, std::vector<Accumulator>& sum) {
+            replay_sum<Accumulator>(starting_version, ending_version, [&](row_id_type row_id) -> Accumulator {return column[row_id];},
+                                    [&](version version_number, Accumulator value) {sum[version_number] = value;});
+        });
+    }, table.get_typed_column(typed_column));
+}
+
+template<typename T>
+T get_max_element(const std::multiset<T, std::greater<>>& max_set) {
     return *max_set.begin();
 }
 
-uint64_t get_min_element(const std::multiset<uint64_t, std::greater<>>& max_set) {
+template<typename T>
+T get_min_element(const std::multiset<T, std::greater<>>& max_set) {
     return *max_set.rbegin();
 }
 
@@ -167,23 +476,38 @@ bool is_in_vector(std::vector<uint64_t>& inserted_values, uint32_t value) {
     return result;
 }
 
+/**
+ * @brief Maximum of a changing multiset of values
+ * @details only the TOP_K largest values are kept ordered, all others are counted in a hashmap.
+ * The ordered set is rebuilt from the hashmap once all of its values are removed.
+ */
+template<typename T>
+struct RunningMax {
+    std::multiset<T, std::greater<>> max_set;
+    std::unordered_map<T, uint32_t> irrelevant_values;
+    bool fill_up = true;
+    uint64_t rebuilds = 0;
 
-void TimelineIndex::threading_max(uint32_t starting_version, uint32_t ending_version, uint16_t index, std::vector<uint64_t>& max) {
-    auto activated_tuples = time_travel(starting_version);
-    std::multiset<uint64_t, std::greater<>> max_set;
-    std::unordered_map<uint64_t, uint32_t> irrelevant_values;
-    irrelevant_values.reserve(5'000'000);
+    explicit RunningMax(uint64_t expected_values) {
+        irrelevant_values.reserve(expected_values);
+    }
 
-    // insert activated_tuples in a similar approach to rebuilding max_set
-    bool fill_up = true;
-    for(auto& tuples: activated_tuples) {
-        auto inserting_value = tuples[index];
-        if(fill_up) {
+    bool empty() const {
+        return max_set.empty();
+    }
+
+    T max() const {
+        return get_max_element(max_set);
+    }
+
+    void insert(T inserting_value) {
+        if(fill_up || max_set.empty()) {
             max_set.insert(inserting_value);
             if(max_set.size() >= TOP_K) fill_up = false;
-            continue;
+            return;
         }
 
+        // get smallest element in descending multiset
         auto smallest_element = get_min_element(max_set);
         if(inserting_value > smallest_element) {
             if(max_set.size() >= TOP_K) {
@@ -196,111 +520,556 @@ void TimelineIndex::threading_max(uint32_t starting_version, uint32_t ending_ver
         }
     }
 
-    max[starting_version] = max_set.empty() ? 0:get_max_element(max_set);
-    fill_up = max_set.size() < TOP_K;
-
-    for(uint32_t i=starting_version+1; i<ending_version; ++i) {
-        auto events = version_map.get_events(i);
-        for(auto& event : events) {
-
-            auto inserting_value = table.tuples[event.row_id].first[index];
-            auto smallest_element = max_set.empty() ? 0 : get_min_element(max_set);
-
-            if(event.type == EventType::INSERT) {
-                // get smallest element in descending multiset
+    void remove(T removing_value) {
+        T smallest_element = max_set.empty() ? 0 : get_min_element(max_set);
+        if(removing_value >= smallest_element) {
+            // erase from multiset
+            max_set.erase(max_set.find(removing_value));
+        } else {
+            --irrelevant_values[removing_value];
+        }
 
-                if(fill_up || max_set.empty()) {
-                    max_set.insert(inserting_value);
-                    if(max_set.size() >= TOP_K) fill_up = false;
-                } else if(inserting_value > smallest_element) {
+        if(max_set.empty()) {
+            ++rebuilds;
+            fill_up = true;
+            for(auto [key, amount] : irrelevant_values) {
+                for(int cnt=0; cnt<amount; cnt++) {
+                    if(fill_up) {
+                        max_set.insert(key);
+                        --irrelevant_values[key];
+                        if(max_set.size() >= TOP_K) fill_up = false;
+                        continue;
+                    }
+                    smallest_element = get_min_element(max_set);
+                    if(smallest_element >= key) break;
                     if(max_set.size() >= TOP_K) {
                         max_set.erase(max_set.find(smallest_element));
                         ++irrelevant_values[smallest_element];
                     }
-                    max_set.insert(inserting_value);
-                } else {
-                    ++irrelevant_values[inserting_value];
+                    max_set.insert(key);
+                    --irrelevant_values[key];
                 }
+            }
+        }
+    }
+};
+
+
+template<typename T, typename Values, typename Store>
+void TimelineIndex::replay_max(version starting_version, version ending_version, Values values, Store store) const {
+#ifdef STATISTICS
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t events_applied = 0;
+#endif
+    auto bitset = reconstruct(starting_version);
+    RunningMax<T> running_max(5'000'000);
+
+    for(auto row_id : table.select_rows(bitset, {})) {
+        running_max.insert(values(row_id));
+    }
+    store(starting_version, running_max.empty() ? T(0) : running_max.max());
+
+    std::vector<Event> buffer;
+    for(version i=starting_version+1; i<ending_version; ++i) {
+        auto events = version_map.get_events(i, i+1, buffer);
+#ifdef STATISTICS
+        events_applied += events.size();
+#endif
+        for(auto& event : events) {
+            if(event.type == EventType::INSERT) {
+                running_max.insert(values(event.row_id));
             } else {
-                if(inserting_value >= smallest_element) {
-                    // erase from multiset
-                    max_set.erase(max_set.find(inserting_value));
-                } else {
-                    --irrelevant_values[inserting_value];
-                }
+                running_max.remove(values(event.row_id));
+            }
+        }
+        store(i, running_max.empty() ? T(0) : running_max.max());
+    }
 
-                if(max_set.empty()) {
-                    fill_up = true;
-                    for(auto [key, amount] : irrelevant_values) {
-                        for(int cnt=0; cnt<amount; cnt++) {
-                            if(fill_up) {
-                                max_set.insert(key);
-                                --irrelevant_values[key];
-                                if(max_set.size() >= TOP_K) fill_up = false;
-                                continue;
-                            }
-                            smallest_element = get_min_element(max_set);
-                            if(smallest_element >= key) break;
-                            if(max_set.size() >= TOP_K) {
-                                max_set.erase(max_set.find(smallest_element));
-                                ++irrelevant_values[smallest_element];
-                            }
-                            max_set.insert(key);
-                            --irrelevant_values[key];
-                        }
-                    }
+#ifdef STATISTICS
+    auto end = std::chrono::high_resolution_clock::now();
+    statistics.record_thread(ThreadRecord{"max", starting_version, ending_version, events_applied, running_max.rebuilds,
+                                          static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end-start).count())});
+#endif
+}
+
+void TimelineIndex::threading_max(version starting_version, version ending_version, uint16_t index, std::vector<uint64_t>& max) const {
+    replay_max<uint64_t>(starting_version, ending_version, [&](row_id_type row_id) {return table.row(row_id)[index];},
+                         [&](version version_number, uint64_t value) {max[version_number] = value;});
+}
 
 
-                }
+
+std::vector<uint64_t> TimelineIndex::temporal_max(uint16_t index) const {
+    std::shared_lock queries(lock.queries);
+    if(!table.has_column(index)) throw std::invalid_argument("Column does not exist");
+    return partition_versions<uint64_t>([&](version starting_version, version ending_version, std::vector<uint64_t>& max) {
+        threading_max(starting_version, ending_version, index, max);
+    });
+}
+
+std::vector<RollupBucket> TimelineIndex::temporal_max_rollup(uint16_t index, version bucket_width) const {
+    std::shared_lock queries(lock.queries);
+    if(!table.has_column(index)) throw std::invalid_argument("Column does not exist");
+    return partition_buckets(bucket_width, [&](version starting_version, version ending_version, RollupWriter writer) {
+        replay_max<uint64_t>(starting_version, ending_version, [&](row_id_type row_id) {return table.row(row_id)[index];}, writer);
+    });
+}
+
+TypedSeries TimelineIndex::temporal_max_typed(uint16_t typed_column) const {
+    std::shared_lock queries(lock.queries);
+    return std::visit([&](const auto& column) -> TypedSeries {
+        using Accumulator = AccumulatorType<typename std::decay_t<decltype(column)>::value_type>;
+        return partition_versions<Accumulator>([&](version starting_version, version ending_version, std::vector<Accumulator>& max) {
+            replay_max<Accumulator>(starting_version, ending_version, [&](row_id_type row_id) -> Accumulator {return column[row_id];},
+                                    [&](version version_number, Accumulator value) {max[version_number] = value;});
+        });
+    }, table.get_typed_column(typed_column));
+}
+
+template<typename Counter, typename Values>
+void TimelineIndex::replay_count_distinct(version starting_version, version ending_version, Values values, Counter counter, std::vector<uint64_t>& count) const {
+#ifdef STATISTICS
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t events_applied = 0;
+#endif
+    auto bitset = reconstruct(starting_version);
+    for(auto row_id : table.select_rows(bitset, {})) {
+        counter.insert(values(row_id));
+    }
+    count[starting_version] = counter.count();
+
+    std::vector<Event> buffer;
+    for(version i=starting_version+1; i<ending_version; ++i) {
+        auto events = version_map.get_events(i, i+1, buffer);
+#ifdef STATISTICS
+        events_applied += events.size();
+#endif
+        for(auto& event : events) {
+            if(event.type == EventType::INSERT) {
+                counter.insert(values(event.row_id));
+            } else {
+                counter.remove(values(event.row_id));
             }
         }
-        if(!max_set.empty()) max[i] = get_max_element(max_set);
+        count[i] = counter.count();
     }
+
+#ifdef STATISTICS
+    auto end = std::chrono::high_resolution_clock::now();
+    statistics.record_thread(ThreadRecord{"count distinct", starting_version, ending_version, events_applied, 0,
+                                          static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end-start).count())});
+#endif
 }
 
+std::vector<uint64_t> TimelineIndex::temporal_count_distinct(uint16_t index, bool approximate) const {
+    std::shared_lock queries(lock.queries);
+    if(!table.has_column(index)) throw std::invalid_argument("Column does not exist");
+    auto values = [&](row_id_type row_id) {return table.row(row_id)[index];};
 
+    if(approximate) {
+        return partition_versions<uint64_t>([&](version starting_version, version ending_version, std::vector<uint64_t>& count) {
+            replay_count_distinct(starting_version, ending_version, values, ApproximateDistinctCounter(), count);
+        });
+    }
 
-std::vector<uint64_t> TimelineIndex::temporal_max(uint16_t index) {
-    std::vector<uint64_t> result(version_map.current_version, 0);
+    auto range = table.column_range(index);
+    return partition_versions<uint64_t>([&](version starting_version, version ending_version, std::vector<uint64_t>& count) {
+        replay_count_distinct(starting_version, ending_version, values, ExactDistinctCounter(range.min, range.max, table.get_table_size()), count);
+    });
+}
 
-    std::vector<std::thread> threads;
-    std::vector<ThreadSum> args;
+// nearest rank of the quantile among live values, at least 1
+uint64_t quantile_rank(double quantile, uint64_t live) {
+    return std::max<uint64_t>(1, std::ceil(quantile * live));
+}
+
+void TimelineIndex::threading_quantiles(version starting_version, version ending_version, const std::vector<uint32_t>& codes,
+                                        const std::vector<uint64_t>& dictionary, const std::vector<double>& quantiles,
+                                        std::vector<std::vector<uint64_t>>& results) const {
+#ifdef STATISTICS
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t events_applied = 0;
+#endif
+    FenwickTree counts(dictionary.size());
+    auto store = [&](version version_number) {
+        if(counts.total() == 0) return;
+        for(uint64_t i=0; i<quantiles.size(); i++) {
+            results[i][version_number] = dictionary[counts.find_rank(quantile_rank(quantiles[i], counts.total()))];
+        }
+    };
+
+    auto bitset = reconstruct(starting_version);
+    for(auto row_id : table.select_rows(bitset, {})) {
+        counts.insert(codes[row_id]);
+    }
+    store(starting_version);
+
+    std::vector<Event> buffer;
+    for(version i=starting_version+1; i<ending_version; ++i) {
+        auto events = version_map.get_events(i, i+1, buffer);
+#ifdef STATISTICS
+        events_applied += events.size();
+#endif
+        for(auto& event : events) {
+            if(event.type == EventType::INSERT) {
+                counts.insert(codes[event.row_id]);
+            } else {
+                counts.remove(codes[event.row_id]);
+            }
+        }
+        store(i);
+    }
+
+#ifdef STATISTICS
+    auto end = std::chrono::high_resolution_clock::now();
+    statistics.record_thread(ThreadRecord{"quantiles", starting_version, ending_version, events_applied, 0,
+                                          static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end-start).count())});
+#endif
+}
+
+std::vector<std::vector<uint64_t>> TimelineIndex::temporal_quantiles(uint16_t index, const std::vector<double>& quantiles) const {
+    for(auto quantile : quantiles) {
+        if(!(quantile >= 0 && quantile <= 1)) throw std::invalid_argument("Quantile must be between 0 and 1");
+    }
+
+    std::shared_lock queries(lock.queries);
+    if(!table.has_column(index)) throw std::invalid_argument("Column does not exist");
+    std::vector<std::vector<uint64_t>> result(quantiles.size(), std::vector<uint64_t>(version_map.current_version, 0));
+
+    // dictionary of all values of the column, every row gets the code of its value
+    std::vector<uint64_t> dictionary;
+    dictionary.reserve(table.get_table_size());
+    for(row_id_type row_id=0; row_id<table.get_table_size(); row_id++) {
+        auto values = table.row(row_id);
+        if(!values.empty()) dictionary.push_back(values[index]);
+    }
+    std::sort(dictionary.begin(), dictionary.end());
+    dictionary.erase(std::unique(dictionary.begin(), dictionary.end()), dictionary.end());
+
+    std::vector<uint32_t> codes(table.get_table_size(), 0);
+    for(row_id_type row_id=0; row_id<table.get_table_size(); row_id++) {
+        auto values = table.row(row_id);
+        // reclaimed rows are never alive
+        if(!values.empty()) codes[row_id] = std::lower_bound(dictionary.begin(), dictionary.end(), values[index]) - dictionary.begin();
+    }
+
+    // dropped versions stay 0
+    run_partitioned([&](uint32_t, version starting_version, version ending_version) {
+        threading_quantiles(starting_version, ending_version, codes, dictionary, quantiles, result);
+    });
+
+    return result;
+}
+
+std::vector<row_id_type> TopKChanges::rows_at(version version_number) const {
+    std::vector<row_id_type> result;
+    for(auto& event : std::span(events.data(), offsets[version_number])) {
+        if(event.type == EventType::INSERT) {
+            result.push_back(event.row_id);
+        } else {
+            result.erase(std::find(result.begin(), result.end(), event.row_id));
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// ranks rows by descending value, ties by ascending row id
+struct TopKOrder {
+    bool operator()(const std::pair<uint64_t, row_id_type>& a, const std::pair<uint64_t, row_id_type>& b) const {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    }
+};
+
+// appends the events turning the sorted row ids before into the sorted row ids after
+void append_set_changes(const std::vector<row_id_type>& before, const std::vector<row_id_type>& after, std::vector<Event>& events) {
+    std::vector<row_id_type> changed;
+    std::set_difference(before.begin(), before.end(), after.begin(), after.end(), std::back_inserter(changed));
+    for(auto row_id : changed) events.emplace_back(row_id, NO_ROW, EventType::DELETE);
+    changed.clear();
+    std::set_difference(after.begin(), after.end(), before.begin(), before.end(), std::back_inserter(changed));
+    for(auto row_id : changed) events.emplace_back(row_id, NO_ROW, EventType::INSERT);
+}
+
+void TimelineIndex::threading_top_k(version starting_version, version ending_version, uint16_t index, uint32_t k,
+                                    TopKChanges& changes, std::vector<row_id_type>& first_top, std::vector<row_id_type>& last_top) const {
+#ifdef STATISTICS
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t events_applied = 0;
+#endif
+    // top holds the k best live rows, rest all other live rows
+    std::set<std::pair<uint64_t, row_id_type>, TopKOrder> top;
+    std::set<std::pair<uint64_t, row_id_type>, TopKOrder> rest;
+    std::vector<row_id_type> inserted;
+    std::vector<row_id_type> deleted;
+
+    auto insert = [&](row_id_type row_id) {
+        std::pair<uint64_t, row_id_type> entry{table.row(row_id)[index], row_id};
+        if(top.size() < k) {
+            top.insert(entry);
+            inserted.push_back(row_id);
+        } else if(TopKOrder()(entry, *top.rbegin())) {
+            auto worst = std::prev(top.end());
+            deleted.push_back(worst->second);
+            rest.insert(*worst);
+            top.erase(worst);
+            top.insert(entry);
+            inserted.push_back(row_id);
+        } else {
+            rest.insert(entry);
+        }
+    };
+    auto remove = [&](row_id_type row_id) {
+        std::pair<uint64_t, row_id_type> entry{table.row(row_id)[index], row_id};
+        if(top.erase(entry) == 0) {
+            rest.erase(entry);
+            return;
+        }
+        deleted.push_back(row_id);
+        if(!rest.empty()) {
+            top.insert(*rest.begin());
+            inserted.push_back(rest.begin()->second);
+            rest.erase(rest.begin());
+        }
+    };
+
+    auto bitset = reconstruct(starting_version);
+    for(auto row_id : table.select_rows(bitset, {})) {
+        insert(row_id);
+    }
+    for(auto& [_, row_id] : top) first_top.push_back(row_id);
+    std::sort(first_top.begin(), first_top.end());
+    // the changes of the first version are filled in when the threads are merged
+    changes.offsets.push_back(0);
+
+    std::vector<Event> buffer;
+    for(version i=starting_version+1; i<ending_version; ++i) {
+        auto events = version_map.get_events(i, i+1, buffer);
+#ifdef STATISTICS
+        events_applied += events.size();
+#endif
+        inserted.clear();
+        deleted.clear();
+        for(auto& event : events) {
+            if(event.type == EventType::INSERT) {
+                insert(event.row_id);
+            } else {
+                remove(event.row_id);
+            }
+        }
 
-    uint32_t step_size = version_map.current_version / THREAD_AMOUNT;
+        // rows entering and leaving the top-k during the same version cancel out
+        std::sort(inserted.begin(), inserted.end());
+        std::sort(deleted.begin(), deleted.end());
+        append_set_changes(deleted, inserted, changes.events);
+        changes.offsets.push_back(changes.events.size());
+    }
+
+    for(auto& [_, row_id] : top) last_top.push_back(row_id);
+    std::sort(last_top.begin(), last_top.end());
 
+#ifdef STATISTICS
+    auto end = std::chrono::high_resolution_clock::now();
+    statistics.record_thread(ThreadRecord{"top k", starting_version, ending_version, events_applied, 0,
+                                          static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end-start).count())});
+#endif
+}
+
+TopKChanges TimelineIndex::temporal_top_k(uint16_t index, uint32_t k) const {
+    if(k == 0) throw std::invalid_argument("k must be larger than 0");
+
+    std::shared_lock queries(lock.queries);
+    if(!table.has_column(index)) throw std::invalid_argument("Column does not exist");
+    std::vector<TopKChanges> partial_changes(THREAD_AMOUNT);
+    std::vector<std::vector<row_id_type>> first_tops(THREAD_AMOUNT);
+    std::vector<std::vector<row_id_type>> last_tops(THREAD_AMOUNT);
+    // not a vector<bool>, the threads write their entries concurrently
+    std::vector<uint8_t> used_threads(THREAD_AMOUNT, 0);
+
+    // dropped versions have no changes
+    run_partitioned([&](uint32_t i, version starting_version, version ending_version) {
+        used_threads[i] = 1;
+        threading_top_k(starting_version, ending_version, index, k, partial_changes[i], first_tops[i], last_tops[i]);
+    });
+
+    // the first version of every thread changes the top-k the previous thread ended with
+    TopKChanges result;
+    result.offsets.assign(version_map.base_version, 0);
+    std::vector<row_id_type> previous_top;
     for(uint32_t i=0; i<THREAD_AMOUNT; i++) {
-        uint32_t starting_version = i * step_size;
-        uint32_t ending_version = (i+1) * step_size;
-        args.emplace_back(ThreadSum{result, starting_version, ending_version, index});
-        std::thread thread(&TimelineIndex::threading_max, this, starting_version, ending_version, index, std::ref(result));
-        threads.push_back(std::move(thread));
+        if(!used_threads[i]) continue;
+        append_set_changes(previous_top, first_tops[i], result.events);
+        uint64_t shift = result.events.size();
+        result.offsets.push_back(shift);
+        for(uint64_t v=1; v<partial_changes[i].offsets.size(); v++) {
+            result.offsets.push_back(partial_changes[i].offsets[v] + shift);
+        }
+        result.events.insert(result.events.end(), partial_changes[i].events.begin(), partial_changes[i].events.end());
+        previous_top = std::move(last_tops[i]);
     }
 
-    for(auto& thread : threads) {
-        thread.join();
+    return result;
+}
+
+void TimelineIndex::threading_aggregates(version starting_version, version ending_version, const std::vector<AggregateSpec>& aggregates,
+                                         std::vector<std::vector<uint64_t>>& results) const {
+#ifdef STATISTICS
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t events_applied = 0;
+#endif
+    auto bitset = reconstruct(starting_version);
+    auto row_ids = table.select_rows(bitset, {});
+
+    // running state of every aggregate, maxima only for MAX aggregates
+    std::vector<uint64_t> sums(aggregates.size(), 0);
+    std::vector<std::optional<RunningMax<uint64_t>>> maxima(aggregates.size());
+    for(uint64_t i=0; i<aggregates.size(); i++) {
+        if(aggregates[i].type == AggregateType::MAX) maxima[i].emplace(row_ids.size());
+    }
+
+    // every row is read once for all aggregates
+    auto apply = [&](row_id_type row_id, bool insertion) {
+        const uint64_t* values = table.row(row_id).data();
+        for(uint64_t i=0; i<aggregates.size(); i++) {
+            if(aggregates[i].type == AggregateType::COUNT) {
+                sums[i] += insertion ? 1 : -1;
+                continue;
+            }
+            auto value = values[aggregates[i].index];
+            if(aggregates[i].type == AggregateType::SUM) {
+                sums[i] += insertion ? value : -value;
+            } else if(insertion) {
+                maxima[i]->insert(value);
+            } else {
+                maxima[i]->remove(value);
+            }
+        }
+    };
+    auto store = [&](version version_number) {
+        for(uint64_t i=0; i<aggregates.size(); i++) {
+            if(aggregates[i].type != AggregateType::MAX) {
+                results[i][version_number] = sums[i];
+            } else if(!maxima[i]->empty()) {
+                results[i][version_number] = maxima[i]->max();
+            }
+        }
+    };
+
+    for(auto row_id : row_ids) {
+        apply(row_id, true);
+    }
+    store(starting_version);
+
+    std::vector<Event> buffer;
+    for(version i=starting_version+1; i<ending_version; ++i) {
+        auto events = version_map.get_events(i, i+1, buffer);
+#ifdef STATISTICS
+        events_applied += events.size();
+#endif
+        for(auto& event : events) {
+            apply(event.row_id, event.type == EventType::INSERT);
+        }
+        store(i);
     }
 
+#ifdef STATISTICS
+    uint64_t max_set_rebuilds = 0;
+    for(auto& running_max : maxima) {
+        if(running_max.has_value()) max_set_rebuilds += running_max->rebuilds;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    statistics.record_thread(ThreadRecord{"aggregates", starting_version, ending_version, events_applied, max_set_rebuilds,
+                                          static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end-start).count())});
+#endif
+}
+
+std::vector<std::vector<uint64_t>> TimelineIndex::temporal_aggregates(const std::vector<AggregateSpec>& aggregates) const {
+    std::shared_lock queries(lock.queries);
+    for(auto& aggregate : aggregates) {
+        if(aggregate.type != AggregateType::COUNT && !table.has_column(aggregate.index)) throw std::invalid_argument("Column does not exist");
+    }
+    // dropped versions stay 0
+    std::vector<std::vector<uint64_t>> result(aggregates.size(), std::vector<uint64_t>(version_map.current_version, 0));
+    run_partitioned([&](uint32_t, version starting_version, version ending_version) {
+        threading_aggregates(starting_version, ending_version, aggregates, result);
+    });
 
     return result;
 }
 
-TimelineIndex TimelineIndex::temporal_join(TimelineIndex other) {
+void TimelineIndex::materialize_aggregate(uint16_t index) {
+    // appends wait until the aggregate is registered, so no version is missed
+    std::lock_guard maintenance(lock.maintenance);
+    {
+        std::shared_lock queries(lock.queries);
+        for(auto& aggregate : materialized_aggregates) {
+            if(aggregate.get_index() == index) return;
+        }
+    }
+
+    // only writers modify the version map and they are serialized, so readers can continue while we replay
+    auto series = temporal_aggregates({{AggregateType::SUM, index}, {AggregateType::COUNT, index}, {AggregateType::MAX, index}});
+    std::vector<uint64_t> live_values;
+    {
+        std::shared_lock queries(lock.queries);
+        if(version_map.current_version > version_map.base_version) {
+            auto bitset = reconstruct(version_map.current_version - 1);
+            for(auto row_id : table.select_rows(bitset, {})) {
+                live_values.push_back(table.row(row_id)[index]);
+            }
+        }
+    }
+    MaterializedAggregate aggregate(index, std::move(series[0]), std::move(series[1]), std::move(series[2]), live_values);
+    aggregate.drop_before(version_map.base_version);
+
+    std::unique_lock queries(lock.queries);
+    materialized_aggregates.push_back(std::move(aggregate));
+}
+
+MaterializedValues TimelineIndex::get_materialized(uint16_t index, version query_version) const {
+    std::shared_lock queries(lock.queries);
+    for(auto& aggregate : materialized_aggregates) {
+        if(aggregate.get_index() == index) return aggregate.get(query_version);
+    }
+    throw std::invalid_argument("Aggregate is not materialized");
+}
+
+std::vector<uint64_t> TimelineIndex::get_materialized_series(uint16_t index, AggregateType type) const {
+    std::shared_lock queries(lock.queries);
+    for(auto& aggregate : materialized_aggregates) {
+        if(aggregate.get_index() != index) continue;
+        auto& series = type == AggregateType::SUM ? aggregate.get_sums() : type == AggregateType::COUNT ? aggregate.get_counts() : aggregate.get_maxima();
+        // dropped versions are 0 like in temporal_aggregates
+        std::vector<uint64_t> result(aggregate.get_base_version(), 0);
+        result.insert(result.end(), series.begin(), series.end());
+        return result;
+    }
+    throw std::invalid_argument("Aggregate is not materialized");
+}
+
+TimelineIndex TimelineIndex::temporal_join(const TimelineIndex& other) const {
+    std::shared_lock queries(lock.queries);
+    // locking the same index twice from one thread is not allowed
+    std::shared_lock other_queries(other.lock.queries, std::defer_lock);
+    if(&other != this) other_queries.lock();
     std::unordered_map<uint64_t, Intersection> intersection_map;
     TimelineIndex result(table, other.table);
 
-    uint32_t new_latest_version = std::max(version_map.current_version, other.version_map.current_version);
-    for(uint32_t i=0; i<new_latest_version; i++) {
+    version new_latest_version = std::max(version_map.current_version, other.version_map.current_version);
+    std::vector<Event> buffer_a;
+    std::vector<Event> buffer_b;
+    for(version i=0; i<new_latest_version; i++) {
         std::vector<Event> version_events;
-        auto events_for_a = version_map.get_events(i);
-        auto events_for_b = other.version_map.get_events(i);
+        auto events_for_a = version_map.get_events(i, i+1, buffer_a);
+        auto events_for_b = other.version_map.get_events(i, i+1, buffer_b);
 
-        std::vector<uint32_t> a_insertions;
-        std::vector<uint32_t> b_insertions;
+        std::vector<row_id_type> a_insertions;
+        std::vector<row_id_type> b_insertions;
 
         // iterate through events of a, only apply deletions at first
         for(const auto& event : events_for_a) {
             if(event.type == EventType::DELETE) {
-                uint64_t associated_value = table.tuples[event.row_id].first[0];
+                uint64_t associated_value = table.row(event.row_id)[0];
                 auto& intersection = intersection_map[associated_value];
                 intersection.row_ids_A.erase(event.row_id);
                 for(auto& row_id_B : intersection.row_ids_B) {
@@ -314,7 +1083,7 @@ TimelineIndex TimelineIndex::temporal_join(TimelineIndex other) {
         // same thing for events of b
         for(const auto& event : events_for_b) {
             if(event.type == EventType::DELETE) {
-                uint64_t associated_value = other.table.tuples[event.row_id].first[0];
+                uint64_t associated_value = other.table.row(event.row_id)[0];
                 auto& intersection = intersection_map[associated_value];
                 intersection.row_ids_B.erase(event.row_id);
                 for(auto& row_id_A : intersection.row_ids_A) {
@@ -327,7 +1096,7 @@ TimelineIndex TimelineIndex::temporal_join(TimelineIndex other) {
 
         // now we can apply insertions in the same order
         for(const auto row_id : a_insertions) {
-            uint64_t associated_value = table.tuples[row_id].first[0];
+            uint64_t associated_value = table.row(row_id)[0];
             auto& intersection = intersection_map[associated_value];
             intersection.row_ids_A.insert(row_id);
             for(auto& row_id_B : intersection.row_ids_B) {
@@ -337,7 +1106,7 @@ TimelineIndex TimelineIndex::temporal_join(TimelineIndex other) {
 
         // same for b
         for(const auto row_id : b_insertions) {
-            uint64_t associated_value = other.table.tuples[row_id].first[0];
+            uint64_t associated_value = other.table.row(row_id)[0];
             auto& intersection = intersection_map[associated_value];
             intersection.row_ids_B.insert(row_id);
             for(auto& row_id_A : intersection.row_ids_A) {
@@ -350,3 +1119,130 @@ TimelineIndex TimelineIndex::temporal_join(TimelineIndex other) {
 
     return result;
 }
+
+template<typename Accumulator, typename Values>
+std::vector<Accumulator> TimelineIndex::replay_join_sum(const TimelineIndex& other, Values values) const {
+    std::unordered_map<uint64_t, JoinKeyAggregate<Accumulator>> aggregates;
+
+    version new_latest_version = std::max(version_map.current_version, other.version_map.current_version);
+    std::vector<Accumulator> result(new_latest_version, 0);
+    std::vector<Event> buffer_a;
+    std::vector<Event> buffer_b;
+    // the sum only depends on the live rows, so the events of a version can be applied in any order
+    Accumulator current_sum = 0;
+    for(version i=0; i<new_latest_version; i++) {
+        auto events_for_a = version_map.get_events(i, i+1, buffer_a);
+        auto events_for_b = other.version_map.get_events(i, i+1, buffer_b);
+
+        for(const auto& event : events_for_a) {
+            Accumulator value = values(event.row_id);
+            auto& aggregate = aggregates[table.row(event.row_id)[0]];
+            if(event.type == EventType::INSERT) {
+                ++aggregate.count_A;
+                aggregate.sum_A += value;
+                current_sum += value * aggregate.count_B;
+            } else {
+                --aggregate.count_A;
+                aggregate.sum_A -= value;
+                current_sum -= value * aggregate.count_B;
+            }
+        }
+
+        for(const auto& event : events_for_b) {
+            auto& aggregate = aggregates[other.table.row(event.row_id)[0]];
+            if(event.type == EventType::INSERT) {
+                ++aggregate.count_B;
+                current_sum += aggregate.sum_A;
+            } else {
+                --aggregate.count_B;
+                current_sum -= aggregate.sum_A;
+            }
+        }
+
+        result[i] = current_sum;
+    }
+
+    return result;
+}
+
+std::vector<uint64_t> TimelineIndex::temporal_join_sum(const TimelineIndex& other, uint16_t index) const {
+    std::shared_lock queries(lock.queries);
+    // locking the same index twice from one thread is not allowed
+    std::shared_lock other_queries(other.lock.queries, std::defer_lock);
+    if(&other != this) other_queries.lock();
+    return replay_join_sum<uint64_t>(other, [&](row_id_type row_id) {return table.row(row_id)[index];});
+}
+
+TypedSeries TimelineIndex::temporal_join_sum_typed(const TimelineIndex& other, uint16_t typed_column) const {
+    std::shared_lock queries(lock.queries);
+    std::shared_lock other_queries(other.lock.queries, std::defer_lock);
+    if(&other != this) other_queries.lock();
+    return std::visit([&](const auto& column) -> TypedSeries {
+        using Accumulator = AccumulatorType<typename std::decay_t<decltype(column)>::value_type>;
+        return replay_join_sum<Accumulator>(other, [&](row_id_type row_id) -> Accumulator {return column[row_id];});
+    }, table.get_typed_column(typed_column));
+}
+
+IndexStatistics TimelineIndex::get_statistics() const {
+    return statistics;
+}
+
+void TimelineIndex::reset_statistics() {
+    statistics.reset();
+}
+
+IndexMemoryUsage TimelineIndex::memory_usage() const {
+    std::shared_lock queries(lock.queries);
+    IndexMemoryUsage result{version_map.memory_usage(), {}, table.memory_usage(), snapshot_cache.memory_usage()};
+    result.checkpoints.reserve(checkpoints.size());
+    for(auto& [_, bitset] : checkpoints) {
+        result.checkpoints.push_back(bitset.memory_usage());
+    }
+    return result;
+}
+
+void TimelineIndex::compress_events() {
+    std::lock_guard maintenance(lock.maintenance);
+    std::unique_lock queries(lock.queries);
+    version_map.compress();
+}
+
+void TimelineIndex::set_snapshot_cache_budget(uint64_t bytes) {
+    snapshot_cache.set_budget(bytes);
+}
+
+version TimelineIndex::drop_versions_before(version cutoff, bool reclaim_rows) {
+    std::lock_guard maintenance(lock.maintenance);
+    if(checkpoints.empty() || cutoff <= checkpoints[0].first) {
+        return version_map.base_version;
+    }
+
+    // latest checkpoint that still allows to reconstruct the cutoff
+    auto new_base = std::upper_bound(checkpoints.begin(), checkpoints.end(), cutoff,
+        [](version x, const auto& y) -> bool {return x < y.first;}) - 1;
+    if(new_base == checkpoints.begin()) {
+        return version_map.base_version;
+    }
+    version base_version = new_base->first;
+
+    // only writers modify the version map and they are serialized, so readers can continue while we compact
+    std::vector<uint64_t> live_rows;
+    new_base->second.fill_bits(live_rows);
+    VersionMap compacted = version_map.compact(base_version, live_rows);
+
+    {
+        std::unique_lock queries(lock.queries);
+        version_map = std::move(compacted);
+        checkpoints.erase(checkpoints.begin(), new_base);
+        snapshot_cache.drop_before(base_version);
+        for(auto& aggregate : materialized_aggregates) {
+            aggregate.drop_before(base_version);
+        }
+        // queries read the rows, so they must not run while tuples are freed
+        if(reclaim_rows) {
+            table.reclaim_rows(base_version);
+        }
+    }
+
+    return base_version;
+}
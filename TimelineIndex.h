@@ -6,32 +6,144 @@
 #include "VersionMap.h"
 #include "TemporalTable.h"
 #include "Tree.h"
+#include "IndexStatistics.h"
+#include "SnapshotCache.h"
+#include "DistinctCounter.h"
+#include "FenwickTree.h"
+#include "EventBatch.h"
+#include "MaterializedAggregate.h"
 #include <unordered_set>
 #include <unordered_map>
 #include <algorithm>
+#include <mutex>
+#include <shared_mutex>
 
 #ifndef TIMELINEINDEX_TIMELINEINDEX_H
 #define TIMELINEINDEX_TIMELINEINDEX_H
 
-typedef Tree<uint32_t, 16> checkpoint;
-typedef uint32_t version;
+typedef Tree<uint32_t, CHECKPOINT_BITS> checkpoint;
 
 struct Intersection {
-    std::unordered_set<uint32_t> row_ids_A;
-    std::unordered_set<uint32_t> row_ids_B;
+    std::unordered_set<row_id_type> row_ids_A;
+    std::unordered_set<row_id_type> row_ids_B;
+};
+
+// per join key state of temporal_join_sum
+template<typename Accumulator>
+struct JoinKeyAggregate {
+    uint64_t count_A = 0;
+    Accumulator sum_A = 0;
+    uint64_t count_B = 0;
+};
+
+enum class AggregateType {
+    SUM,
+    MAX,
+    COUNT
+};
+
+/**
+ * @brief One aggregate of a multi aggregate query, the aggregate function applied to column index
+ * @details COUNT counts the live rows and ignores the index
+ */
+struct AggregateSpec {
+    AggregateType type;
+    uint16_t index;
 };
 
 struct ThreadSum {
     std::vector<uint64_t>& sum;
-    uint32_t starting_version;
-    uint32_t ending_version;
+    version starting_version;
+    version ending_version;
     uint16_t index;
 };
 
+/**
+ * @brief Net change between two versions, sorted row ids
+ * @details inserted rows are alive at the second version but not at the first, deleted rows the other way around
+ */
+struct VersionDiff {
+    std::vector<row_id_type> inserted;
+    std::vector<row_id_type> deleted;
+};
+
+/**
+ * @brief Aggregate series of a bucket of consecutive versions
+ * @details a bucket only covers retained versions, it stays 0 if all of its versions were dropped
+ */
+struct RollupBucket {
+    uint64_t min;
+    uint64_t max;
+    double avg;
+    // value of the last version of the bucket
+    uint64_t last;
+
+    bool operator==(const RollupBucket&) const = default;
+};
+
+/**
+ * @brief Top-K rows of every version, encoded as changes to the top-K of the previous version
+ * @details the top-K before the first version is empty, the changes of a version never insert and delete the same row
+ */
+struct TopKChanges {
+    std::vector<Event> events;
+    // end of the events of every version, the events of version v start at offsets[v-1]
+    std::vector<uint64_t> offsets;
+
+    std::span<const Event> changes(version version_number) const {
+        uint64_t start = version_number == 0 ? 0 : offsets[version_number - 1];
+        return {events.data() + start, events.data() + offsets[version_number]};
+    }
+
+    /**
+     * @brief Returns the sorted row ids of the top-K at the given version by replaying the changes
+     */
+    std::vector<row_id_type> rows_at(version version_number) const;
+};
+
+/**
+ * @brief Memory breakdown of a TimelineIndex in bytes
+ * @details checkpoints holds the size of every single checkpoint tree, including its clusters.
+ * The table is referenced by the index and therefore listed separately from the total of the index itself.
+ */
+struct IndexMemoryUsage {
+    VersionMapMemoryUsage version_map;
+    std::vector<uint64_t> checkpoints;
+    TableMemoryUsage table;
+    uint64_t snapshot_cache;
+
+    uint64_t checkpoints_total() {
+        uint64_t result = 0;
+        for(auto size : checkpoints) result += size;
+        return result;
+    }
+
+    uint64_t index_total() {
+        return version_map.events + version_map.versions + checkpoints_total() + snapshot_cache;
+    }
+};
+
+/**
+ * @brief Locks of a TimelineIndex
+ * @details queries hold queries shared, modifications of the version map and checkpoints hold it exclusively.
+ * maintenance serializes appends and compactions. A copied index gets its own locks.
+ */
+struct IndexLock {
+    std::shared_mutex queries;
+    std::mutex maintenance;
+
+    IndexLock() = default;
+    IndexLock(const IndexLock&) {}
+};
+
 /**
  * @brief TimelineIndex class
  * @details This class represents the TimelineIndex working on top of a const TemporalTable.
- * that represent the state of the table at a given version
+ * that represent the state of the table at a given version.
+ * All const member functions are safe to call from many threads on one shared index, their scratch state lives on
+ * the stack of the call and the shared caches lock internally. append_version, compress_events and
+ * drop_versions_before may run concurrently to them, they wait until running queries are finished.
+ * The legacy functions in legacy_functions.cpp do not take the index lock.
  */
 class TimelineIndex {
     TemporalTable& table;
@@ -39,32 +151,269 @@ class TimelineIndex {
     VersionMap version_map;
     std::vector<std::pair<version, checkpoint>> checkpoints;
     const uint64_t temporal_table_size;
+    // shared by concurrent queries, they synchronize internally
+    mutable IndexStatistics statistics;
+    mutable SnapshotCache snapshot_cache;
+    mutable IndexLock lock;
+    // extended by append_version, see materialize_aggregate
+    std::vector<MaterializedAggregate> materialized_aggregates;
+
+    // builds the zone maps of the table and the checkpoints from the version map
+    void build_checkpoints();
+
+    std::pair<version, checkpoint> find_nearest_checkpoint(version query_version) const;
+    std::pair<version, checkpoint> find_earlier_checkpoint(version query_version) const;
+
+    /**
+     * @brief Reconstructs the live set of the given version from the nearest checkpoint or cached snapshot
+     * @param cache_snapshot stores the reconstruction in the snapshot cache, only set by time travels. The seeds of the
+     * replay threads are used once and would push the snapshots of time travels out of the budget
+     */
+    checkpoint reconstruct(version query_version, bool cache_snapshot = false) const;
+
+    // diff for from_version <= to_version, the caller holds the lock
+    VersionDiff diff_events(version from_version, version to_version) const;
+
+    // number of versions between the query version and its nearest checkpoint
+    version checkpoint_distance(version query_version) const;
+
+    /**
+     * @brief Splits the retained versions into THREAD_AMOUNT ranges and runs kernel(thread, starting_version, ending_version)
+     * on its own thread for every range that is not empty
+     */
+    template<typename Kernel>
+    void run_partitioned(Kernel kernel) const;
+
+    /**
+     * @brief Runs kernel(starting_version, ending_version, result) on THREAD_AMOUNT threads over the retained versions
+     * @return one value per version, dropped versions stay 0
+     */
+    template<typename Result, typename Kernel>
+    std::vector<Result> partition_versions(Kernel kernel) const;
+
+    /**
+     * @brief Like partition_versions, but the threads get whole buckets of bucket_width versions
+     * @details runs kernel(starting_version, ending_version, store) where store(version, value) folds the value of
+     * a version into its bucket, the versions have to be stored in ascending order
+     * @return one bucket per bucket_width versions, see RollupBucket
+     */
+    template<typename Kernel>
+    std::vector<RollupBucket> partition_buckets(version bucket_width, Kernel kernel) const;
 
-    std::pair<version, checkpoint> find_nearest_checkpoint(version query_version);
-    std::pair<version, checkpoint> find_earlier_checkpoint(version query_version);
+    // replay kernels, values(row_id) returns the aggregated value of a row and store(version, value) takes the result
+    // of every version. Instantiated in TimelineIndex.cpp only
+    template<typename Accumulator, typename Values, typename Store>
+    void replay_sum(version starting_version, version ending_version, Values values, Store store) const;
+    template<typename T, typename Values, typename Store>
+    void replay_max(version starting_version, version ending_version, Values values, Store store) const;
+    template<typename Counter, typename Values>
+    void replay_count_distinct(version starting_version, version ending_version, Values values, Counter counter, std::vector<uint64_t>& count) const;
+    void threading_quantiles(version starting_version, version ending_version, const std::vector<uint32_t>& codes,
+                             const std::vector<uint64_t>& dictionary, const std::vector<double>& quantiles,
+                             std::vector<std::vector<uint64_t>>& results) const;
+    void threading_top_k(version starting_version, version ending_version, uint16_t index, uint32_t k,
+                         TopKChanges& changes, std::vector<row_id_type>& first_top, std::vector<row_id_type>& last_top) const;
+    template<typename Accumulator, typename Values>
+    std::vector<Accumulator> replay_join_sum(const TimelineIndex& other, Values values) const;
 
 public:
+    /**
+     * @details throws std::invalid_argument if the table has more rows than a checkpoint holds, see CHECKPOINT_BITS
+     */
     explicit TimelineIndex(TemporalTable& table);
     explicit TimelineIndex(TemporalTable& table, TemporalTable& joined_table);
+
+    /**
+     * @brief Builds the index with a histogram of the events per version, e.g. collected by a TableLoader
+     * @details the histogram replaces the counting pass over the table, see VersionMap
+     */
+    TimelineIndex(TemporalTable& table, const std::vector<event_offset>& version_histogram);
+    /**
+     * @brief Appends a new version with the given events
+     * @details throws std::invalid_argument if an event refers to a row that is not in the table or not in a checkpoint
+     */
     void append_version(std::vector<Event>& events);
-    std::vector<Tuple> time_travel(version query_version);
 
+    // number of versions, the latest version is one below
+    version get_current_version() const;
+
+    std::vector<Tuple> time_travel(version query_version) const;
+
+    /**
+     * @brief Time travel that only returns the tuples satisfying all predicates
+     * @details uses the zone maps of the table to skip blocks of rows that cannot match
+     */
+    std::vector<Tuple> time_travel_filtered(version query_version, const std::vector<Predicate>& predicates) const;
+
+    /**
+     * @brief Time travel that only materializes the projected columns, optionally filtered by predicates
+     * @details the live rows are final before any value is copied, so columns outside of the projection are never read
+     * @return the projected values in columnar layout, see ColumnarSnapshot
+     */
+    ColumnarSnapshot time_travel_projected(version query_version, const std::vector<uint16_t>& projection,
+                                           const std::vector<Predicate>& predicates = {}) const;
+
+    /**
+     * @brief Time travels to several versions at once, sharing the replay between nearby versions
+     * @details the versions are processed in ascending order, a version is reached by replaying forward from the
+     * previous one whenever that is closer than its nearest checkpoint
+     * @return the snapshots in the order of query_versions
+     */
+    std::vector<std::vector<Tuple>> time_travel_batch(const std::vector<version>& query_versions) const;
+
+
+    /**
+     * @brief Returns the rows inserted and deleted between two versions
+     * @details only the events between the versions are read, a row inserted and deleted again in between cancels out.
+     * The cost depends on the number of events in the range and not on the size of the snapshots.
+     * If from_version is larger than to_version the diff goes backwards in time
+     */
+    VersionDiff diff(version from_version, version to_version) const;
+
+    /**
+     * @brief Appends the events starting at position to the batch, until it holds batch_size events or end_version is reached
+     * @details the projected column values are read straight from the rows. The versions of the exported range must not be
+     * dropped while the export runs, throws std::invalid_argument if position is before the retained history or a
+     * projected column does not exist, the batch is left unchanged in both cases
+     * @return position of the first event that was not exported, its version is end_version once the range is done
+     */
+    ExportPosition export_events(ExportPosition position, version end_version, const std::vector<uint16_t>& projection,
+                                 uint64_t batch_size, EventBatch& batch) const;
+
+    // temporal_sum and temporal_max throw std::invalid_argument if the rows do not have the column
+    void threading_sum(version starting_version, version ending_version, uint16_t index, std::vector<uint64_t>& sum) const;
+    std::vector<uint64_t> temporal_sum(uint16_t index) const;
+    void threading_max(version starting_version, version ending_version, uint16_t index, std::vector<uint64_t>& max) const;
+    std::vector<uint64_t> temporal_max(uint16_t index) const;
+
+    /**
+     * @brief temporal_sum and temporal_max downsampled to buckets of bucket_width versions
+     * @details bucket b covers the versions [b * bucket_width, (b+1) * bucket_width), the last one may be shorter.
+     * The replay folds every version into its bucket right away, so the full series is never stored.
+     * Throws std::invalid_argument if bucket_width is 0 or the rows do not have the column
+     */
+    std::vector<RollupBucket> temporal_sum_rollup(uint16_t index, version bucket_width) const;
+    std::vector<RollupBucket> temporal_max_rollup(uint16_t index, version bucket_width) const;
+
+    /**
+     * @brief Computes the number of distinct values of a column alive at every version
+     * @details the exact mode keeps a reference count per value, in a dense array if the value range of the column
+     * is small and in a hashmap otherwise. The approximate mode uses an ApproximateDistinctCounter with fixed memory
+     * for huge domains, its results have a standard error of about 1.6%
+     */
+    std::vector<uint64_t> temporal_count_distinct(uint16_t index, bool approximate = false) const;
+
+    /**
+     * @brief Computes quantiles of a column among the live rows for every version, e.g. {0.5, 0.95, 0.99}
+     * @details the values are dictionary encoded and counted in a FenwickTree during one replay for all quantiles.
+     * A quantile q is the value with rank max(1, ceil(q * live rows)) in ascending order (nearest rank), 0 if no row is alive.
+     * Throws std::invalid_argument if a quantile is outside of [0, 1]
+     * @return one series per quantile in the order of quantiles, each with one value per version
+     */
+    std::vector<std::vector<uint64_t>> temporal_quantiles(uint16_t index, const std::vector<double>& quantiles) const;
+
+    /**
+     * @brief Computes the k rows with the largest values of a column for every version
+     * @details rows with equal values are ranked by their row id. The result only holds the rows entering and leaving
+     * the top-k, so its size depends on how often the top-k changes and not on k times the number of versions.
+     * Throws std::invalid_argument if k is 0
+     */
+    TopKChanges temporal_top_k(uint16_t index, uint32_t k) const;
+
+    /**
+     * @brief temporal_sum and temporal_max over a typed column of the table, see TemporalTable::add_typed_column
+     * @details the kernels are instantiated for every column type, the series has the AccumulatorType of the column.
+     * Floating point sums are maintained incrementally and may differ from a fresh summation by rounding errors
+     */
+    TypedSeries temporal_sum_typed(uint16_t typed_column) const;
+    TypedSeries temporal_max_typed(uint16_t typed_column) const;
+
+    void threading_aggregates(version starting_version, version ending_version, const std::vector<AggregateSpec>& aggregates,
+                              std::vector<std::vector<uint64_t>>& results) const;
+
+    /**
+     * @brief Computes several temporal aggregates in one replay of the events
+     * @details every event reads its row once and updates all aggregates, so the checkpoints, events and rows are
+     * only touched once instead of once per aggregate. The results match temporal_sum and temporal_max.
+     * Throws std::invalid_argument if the rows do not have the column of an aggregate
+     * @return one series per aggregate in the order of aggregates, each with one value per version
+     */
+    std::vector<std::vector<uint64_t>> temporal_aggregates(const std::vector<AggregateSpec>& aggregates) const;
+
+    /**
+     * @brief Registers a column whose sum, count and max are stored for every version
+     * @details the series are computed once in a parallel replay, afterwards append_version extends them with the
+     * events of the new version only. Registering a column twice has no effect
+     */
+    void materialize_aggregate(uint16_t index);
+
+    /**
+     * @brief Returns the sum, count and max of a registered column at the given version
+     * @details throws std::invalid_argument if the column is not registered or the version was dropped or does not exist
+     */
+    MaterializedValues get_materialized(uint16_t index, version query_version) const;
+
+    /**
+     * @brief Returns the stored series of a registered column, matches temporal_aggregates for the same aggregate
+     * @details throws std::invalid_argument if the column is not registered
+     */
+    std::vector<uint64_t> get_materialized_series(uint16_t index, AggregateType type) const;
+
+    TimelineIndex temporal_join(const TimelineIndex& other) const;
+
+    /**
+     * @brief Computes SUM of the given column of this table over the temporal join with other for every version
+     * @details the join result is never materialized, the sweep keeps the number of live rows on both sides and the
+     * partial sum of this side per join key. A row of this side contributes its value times the number of matching
+     * rows of other, so the cost only depends on the number of input events and not on the size of the join.
+     * The sum over a column of other is other.temporal_join_sum(*this, index).
+     */
+    std::vector<uint64_t> temporal_join_sum(const TimelineIndex& other, uint16_t index) const;
+    TypedSeries temporal_join_sum_typed(const TimelineIndex& other, uint16_t typed_column) const;
+
+    std::vector<Tuple> time_travel_joined(version query_version) const;
+
+    /**
+     * @brief Returns a snapshot of the statistics collected so far
+     * @details only filled if compiled with STATISTICS, see IndexStatistics
+     */
+    IndexStatistics get_statistics() const;
+    void reset_statistics();
+
+    IndexMemoryUsage memory_usage() const;
+
+    /**
+     * @brief Sets the byte budget for caching reconstructed snapshots of time travels
+     * @details cached snapshots are used like additional checkpoints, a budget of 0 disables and clears the cache
+     */
+    void set_snapshot_cache_budget(uint64_t bytes);
 
-    void threading_sum(uint32_t starting_version, uint32_t ending_version, uint16_t index, std::vector<uint64_t>& sum);
-    std::vector<uint64_t> temporal_sum(uint16_t index);
-    void threading_max(uint32_t starting_version, uint32_t ending_version, uint16_t index, std::vector<uint64_t>& max);
-    std::vector<uint64_t> temporal_max(uint16_t index);
-    TimelineIndex temporal_join(TimelineIndex other);
+    /**
+     * @brief Switches the event list to the compressed layout, see CompressedEventList
+     * @details time travel, aggregates and joins decode the events on the fly, the legacy functions need the plain layout
+     */
+    void compress_events();
 
-    std::vector<Tuple> time_travel_joined(version query_version);
+    /**
+     * @brief Drops the history before the given version
+     * @details the latest checkpoint at or before the cutoff becomes the new base, all older checkpoints and events
+     * are removed and the remaining versions are rebased onto the compacted event array. Versions keep their numbers,
+     * queries before the new base throw. Running queries finish on the old state before the compacted one is swapped in.
+     * The materialized aggregates drop their values of the removed versions as well.
+     * @param cutoff oldest version that must stay queryable
+     * @param reclaim_rows frees the tuples of rows deleted before the new base, only safe if no other index
+     * over the same table still needs them. Nothing is reclaimed for tables with an arena, see TemporalTable::reclaim_rows
+     * @return the new base version
+     */
+    version drop_versions_before(version cutoff, bool reclaim_rows = false);
 
 
 
-    std::vector<uint64_t> temporal_sum_original(uint16_t index);
-    std::vector<uint64_t> temporal_max_original(uint16_t index);
-    std::vector<uint64_t> temporal_max_hashmap(uint16_t index);
-    std::vector<uint64_t> temporal_max_multiset(uint16_t index);
-    std::vector<Tuple> time_travel_original(version query_version);
+    std::vector<uint64_t> temporal_sum_original(uint16_t index) const;
+    std::vector<uint64_t> temporal_max_original(uint16_t index) const;
+    std::vector<uint64_t> temporal_max_hashmap(uint16_t index) const;
+    std::vector<uint64_t> temporal_max_multiset(uint16_t index) const;
+    std::vector<Tuple> time_travel_original(version query_version) const;
 };
 
 
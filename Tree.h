@@ -19,10 +19,10 @@ public:
     void remove(T value) {
         actual_tree.remove(hash(value));
     }
-    bool member(T value) {
+    bool member(T value) const {
         return actual_tree.member(hash(value));
     }
-    std::optional<T> min() {
+    std::optional<T> min() const {
         std::optional<uint64_t> result = actual_tree.min();
         if(result == std::nullopt) return std::nullopt;
         return hash(result.value());
@@ -49,6 +49,8 @@ class Tree<T, bit_length> {
             }
         }
     }
+    Tree(Tree<T, bit_length>&& other) = default;
+    Tree& operator=(Tree<T, bit_length>&& other) = default;
 
 
 
@@ -115,20 +117,20 @@ class Tree<T, bit_length> {
         }
     }
 
-    bool member(T value) {
+    bool member(T value) const {
         if (value == minimum) return true;
         if (bottom_layer[value >> (bit_length/2 + bit_length%2)] == nullptr) return false;
         return bottom_layer[value >> (bit_length/2 + bit_length%2)]->member(value & bitmask_low);
     }
 
-    std::optional<T> min() {
+    std::optional<T> min() const {
         return minimum;
     }
-    std::optional<T> max() {
+    std::optional<T> max() const {
         return maximum;
     }
 
-    std::optional<T> succ(T value) {
+    std::optional<T> succ(T value) const {
         if(minimum.has_value() && value < minimum) return minimum;
         std::optional<T> max_in_cluster = bottom_layer[value>>(bit_length/2 + bit_length%2)] == nullptr ? std::nullopt : bottom_layer[value >> (bit_length/2 + bit_length%2)]->max();
         if(max_in_cluster.has_value() && max_in_cluster.value() > (value & bitmask_low)) {
@@ -145,13 +147,25 @@ class Tree<T, bit_length> {
         }
     }
 
-    std::optional<T> pred(T value);
+    std::optional<T> pred(T value) const;
 
-    uint64_t get_set_bits() {
+    uint64_t get_set_bits() const {
         return set_bits;
     }
 
-    void fill_bits(std::vector<uint64_t> &fill) {
+    /**
+     * @brief Returns the bytes used by this tree including all allocated clusters
+     */
+    uint64_t memory_usage() const {
+        uint64_t result = sizeof(*this) + bottom_layer.capacity() * sizeof(bottom_layer[0]);
+        if(upper_layer != nullptr) result += upper_layer->memory_usage();
+        for(auto& cluster : bottom_layer) {
+            if(cluster != nullptr) result += cluster->memory_usage();
+        }
+        return result;
+    }
+
+    void fill_bits(std::vector<uint64_t> &fill) const {
         uint64_t current = 0;
         if(member(current)) fill.push_back(current);
         while(true) {
@@ -225,7 +239,7 @@ public:
         }
     }
 
-    bool member(T value) {
+    bool member(T value) const {
         switch (state) {
             case State::EMPTY:
                 return false;
@@ -238,7 +252,7 @@ public:
         }
     }
 
-    std::optional<T> min() {
+    std::optional<T> min() const {
         switch (state) {
             case State::EMPTY:
                 return std::nullopt;
@@ -251,7 +265,7 @@ public:
         }
     }
 
-    std::optional<T> max() {
+    std::optional<T> max() const {
         switch (state) {
             case State::EMPTY:
                 return std::nullopt;
@@ -264,21 +278,21 @@ public:
         }
     }
 
-    std::optional<T> succ(T value) {
+    std::optional<T> succ(T value) const {
         if(value == 0 && (state == State::ONE || state == State::BOTH)) {
             return 1;
         }
         return std::nullopt;
     }
 
-    std::optional<T> pred(T value) {
+    std::optional<T> pred(T value) const {
         if(value == 1 && (state == State::ZERO || state == State::BOTH)) {
             return 0;
         }
         return std::nullopt;
     }
 
-    uint64_t get_set_bits() {
+    uint64_t get_set_bits() const {
         switch(state) {
             case State::EMPTY:
                 return 0;
@@ -290,6 +304,10 @@ public:
                 return 2;
         }
     }
+
+    uint64_t memory_usage() const {
+        return sizeof(*this);
+    }
 private:
     State state;
 };
@@ -3,7 +3,7 @@
 //
 #include "VersionMap.h"
 
-VersionMap::VersionMap(TemporalTable& table) : events(table.get_number_of_events()), event_number(table.get_number_of_events()), versions(table.next_version + 1) {
+VersionMap::VersionMap(const TemporalTable& table) : events(table.get_number_of_events()), event_number(table.get_number_of_events()), versions(table.next_version + 1) {
     // apply counting sort on the temporal table
     // offset of 1 is to avoid the double summation from the last loop
     // e.g. starting of 0 is 0 and not num of tuples with 1
@@ -14,48 +14,149 @@ VersionMap::VersionMap(TemporalTable& table) : events(table.get_number_of_events
         }
     }
 
+    place_events(table);
+}
+
+VersionMap::VersionMap(const TemporalTable& table, const std::vector<event_offset>& histogram) : events(table.get_number_of_events()), versions(table.next_version + 1), event_number(table.get_number_of_events()) {
+    if(histogram.size() != table.next_version) throw std::invalid_argument("Histogram does not match the number of versions");
+    // same offset of 1 as in the counting sort
+    std::copy(histogram.begin(), histogram.end(), versions.begin() + 1);
+    place_events(table);
+}
+
+void VersionMap::place_events(const TemporalTable& table) {
     // to get the first index where we insert, we need to add the previous value
     for(uint64_t i = 1; i < versions.size(); ++i) {
         versions[i] += versions[i - 1];
     }
 
     // now we can insert the events, this also initializes the version map correctly
-    for(int i = 0; i < table.tuples.size(); ++i) {
+    for(row_id_type i = 0; i < table.tuples.size(); ++i) {
         auto& current_tuple_lifespan = table.tuples[i].second;
-        events.insert(Event(i, -1, EventType::INSERT), versions[current_tuple_lifespan.start]);
+        events.insert(Event(i, NO_ROW, EventType::INSERT), versions[current_tuple_lifespan.start]);
         ++versions[current_tuple_lifespan.start];
 
         if(current_tuple_lifespan.end.has_value()) {
-            events.insert(Event(i, -1, EventType::DELETE), versions[current_tuple_lifespan.end.value()]);
+            events.insert(Event(i, NO_ROW, EventType::DELETE), versions[current_tuple_lifespan.end.value()]);
             ++versions[current_tuple_lifespan.end.value()];
         }
     }
 
+    // the last entry only served the counting sort, there are no events at next_version
+    versions.pop_back();
     current_version = table.next_version;
 }
 
 
-std::span<Event> VersionMap::get_events(uint32_t version) {
-    return get_events(version, version+1);
+std::span<const Event> VersionMap::get_events(version version_number) const {
+    return get_events(version_number, version_number+1);
 }
 
-std::span<Event> VersionMap::get_events(uint32_t start_version, uint32_t end_version) {
-    if(start_version >= versions.size() || end_version >= versions.size()) {
+std::span<const Event> VersionMap::get_events(version start_version, version end_version) const {
+    if(compressed_events.has_value()) {
+        throw std::logic_error("Events are compressed, a buffer is needed to decode them");
+    }
+    if(start_version >= current_version || end_version > current_version || end_version <= base_version) {
         // we will allow this case and return no events
         return {};
         throw std::invalid_argument("Version does not exist");
     }
 
-    uint32_t start_index = start_version == 0 ? 0 : versions[start_version - 1];
-    uint32_t end_index = versions[end_version - 1];
+    // dropped versions have no events
+    start_version = std::max(start_version, base_version);
+    event_offset start_index = start_version == base_version ? 0 : versions[start_version - base_version - 1];
+    event_offset end_index = versions[end_version - base_version - 1];
 
     return events.get_events(start_index, end_index);
 }
 
+std::span<const Event> VersionMap::get_events(version start_version, version end_version, std::vector<Event>& buffer) const {
+    if(!compressed_events.has_value()) {
+        return get_events(start_version, end_version);
+    }
+
+    buffer.clear();
+    if(start_version >= current_version || end_version > current_version || end_version <= base_version) {
+        return {};
+    }
+
+    start_version = std::max(start_version, base_version);
+    for(version version_number = start_version; version_number < end_version; ++version_number) {
+        uint64_t block = version_number - base_version;
+        event_offset start_index = block == 0 ? 0 : versions[block - 1];
+        compressed_events->decode_block(block, start_index, versions[block] - start_index, buffer);
+    }
+
+    return buffer;
+}
+
+void VersionMap::compress() {
+    if(compressed_events.has_value()) return;
+
+    CompressedEventList result;
+    for(version version_number = base_version; version_number < current_version; ++version_number) {
+        auto version_events = get_events(version_number, version_number + 1);
+        for(auto& event : version_events) {
+            if(event.row_id_second != NO_ROW) {
+                throw std::invalid_argument("Joined events can not be compressed");
+            }
+        }
+        result.append_block(version_events);
+    }
+    result.shrink_to_fit();
+
+    compressed_events = std::move(result);
+    events = EventList();
+}
+
+bool VersionMap::is_compressed() const {
+    return compressed_events.has_value();
+}
+
 void VersionMap::register_version(std::vector<Event>& events) {
+    if(compressed_events.has_value()) {
+        compressed_events->append_block(events);
+        ++current_version;
+        event_number += events.size();
+        versions.push_back(event_number);
+        return;
+    }
     this->events.append_list(events);
     ++current_version;
     event_number += events.size();
     versions.push_back(event_number);
 }
 
+
+VersionMapMemoryUsage VersionMap::memory_usage() const {
+    uint64_t event_bytes = compressed_events.has_value() ? compressed_events->memory_usage() : events.memory_usage();
+    return {event_bytes, versions.capacity() * sizeof(event_offset)};
+}
+
+VersionMap VersionMap::compact(version new_base_version, const std::vector<uint64_t>& live_rows) const {
+    VersionMap result;
+    result.base_version = new_base_version;
+    result.current_version = current_version;
+
+    std::vector<Event> buffer;
+    auto kept_events = get_events(new_base_version + 1, current_version, buffer);
+    std::vector<Event> compacted_events;
+    compacted_events.reserve(live_rows.size() + kept_events.size());
+    for(auto row_id : live_rows) {
+        compacted_events.emplace_back(row_id, NO_ROW, EventType::INSERT);
+    }
+    compacted_events.insert(compacted_events.end(), kept_events.begin(), kept_events.end());
+
+    result.versions.reserve(current_version - new_base_version);
+    result.versions.push_back(live_rows.size());
+    event_offset dropped_events = versions[new_base_version - base_version];
+    for(uint64_t i = new_base_version + 1; i < current_version; ++i) {
+        result.versions.push_back(versions[i - base_version] - dropped_events + live_rows.size());
+    }
+
+    result.event_number = compacted_events.size();
+    result.events.append_list(std::move(compacted_events));
+    if(compressed_events.has_value()) result.compress();
+
+    return result;
+}
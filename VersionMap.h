@@ -3,13 +3,22 @@
 //
 #pragma once
 #include "EventList.h"
+#include "CompressedEventList.h"
 #include <vector>
+#include <optional>
 #include "TemporalTable.h"
 
 
 #ifndef TIMELINEINDEX_VERSIONMAP_H
 #define TIMELINEINDEX_VERSIONMAP_H
 
+/**
+ * @brief Bytes allocated by a VersionMap, split into the event array and the version offsets
+ */
+struct VersionMapMemoryUsage {
+    uint64_t events;
+    uint64_t versions;
+};
 
 /**
  * @brief VersionMap class
@@ -18,16 +27,32 @@
  * better used for couting sort.
  */
 class VersionMap {
-    // entry versions[i] points to the last event of version i
+    // entry versions[i] points behind the last event of version base_version + i
     EventList events;
-    std::vector<uint32_t> versions;
+    std::vector<event_offset> versions;
+    // replaces events once the map is compressed
+    std::optional<CompressedEventList> compressed_events;
+
+    /**
+     * @brief Turns the number of events per version, stored at versions[version + 1], into offsets and inserts the events
+     */
+    void place_events(const TemporalTable& table);
 
 public:
     uint64_t current_version{0};
     uint64_t event_number{0};
+    // versions before the base were dropped, the events of the base version insert every tuple alive at it
+    version base_version{0};
 
     VersionMap() = default;
-    VersionMap(TemporalTable& table);
+    VersionMap(const TemporalTable& table);
+
+    /**
+     * @brief Builds the map from a histogram with the number of events of every version, e.g. from a TableLoader
+     * @details skips the counting pass over the table, throws std::invalid_argument if the histogram does not have
+     * one entry per version of the table
+     */
+    VersionMap(const TemporalTable& table, const std::vector<event_offset>& histogram);
 
     /**
      * @brief Inserts all events for the new version
@@ -41,7 +66,7 @@ public:
     * @param version
     * @return
     */
-    std::span<Event> get_events(uint32_t version);
+    std::span<const Event> get_events(version version_number) const;
 
 
     /**
@@ -50,7 +75,37 @@ public:
      * @param end_version
      * @return
      */
-    std::span<Event> get_events(uint32_t start_version, uint32_t end_version);
+    std::span<const Event> get_events(version start_version, version end_version) const;
+
+    /**
+     * @brief Returns all events between the given versions [inclusive, exclusive), works on compressed maps
+     * @details compressed events are decoded into the buffer, otherwise the buffer stays untouched.
+     * Reusing the buffer over several calls avoids allocations.
+     * @param start_version
+     * @param end_version
+     * @param buffer
+     * @return
+     */
+    std::span<const Event> get_events(version start_version, version end_version, std::vector<Event>& buffer) const;
+
+    /**
+     * @brief Switches to the compressed event layout and frees the plain event array
+     * @details only possible for maps built from a single table, joined maps keep their layout
+     */
+    void compress();
+    bool is_compressed() const;
+
+    VersionMapMemoryUsage memory_usage() const;
+
+    /**
+     * @brief Returns a copy of this map without the versions before new_base_version
+     * @details the events up to and including new_base_version are replaced by one insertion per live row,
+     * all later events are kept and the offsets are rebased onto the new event array
+     * @param new_base_version
+     * @param live_rows row ids alive at new_base_version
+     * @return
+     */
+    VersionMap compact(version new_base_version, const std::vector<uint64_t>& live_rows) const;
 
 };
 
@@ -12,7 +12,7 @@ uint64_t get_min_element_legacy(const std::multiset<uint64_t, std::greater<>>& m
     return *max_set.rbegin();
 }
 
-std::vector<uint64_t> TimelineIndex::temporal_max_original(uint16_t index) {
+std::vector<uint64_t> TimelineIndex::temporal_max_original(uint16_t index) const {
     std::vector<uint64_t> result;
     std::multiset<uint64_t, std::greater<>> max_set;
     const uint16_t k = 100;
@@ -29,7 +29,7 @@ std::vector<uint64_t> TimelineIndex::temporal_max_original(uint16_t index) {
         auto events = version_map.get_events(i);
         for(auto& event : events) {
 
-            auto inserting_value = table.tuples[event.row_id].first[index];
+            auto inserting_value = table.row(event.row_id)[index];
             auto smallest_element = max_set.empty() ? 0 : get_min_element_legacy(max_set);
 
             if(event.type == EventType::INSERT) {
@@ -87,7 +87,7 @@ std::vector<uint64_t> TimelineIndex::temporal_max_original(uint16_t index) {
 }
 
 
-std::vector<uint64_t> TimelineIndex::temporal_sum_original(uint16_t index) {
+std::vector<uint64_t> TimelineIndex::temporal_sum_original(uint16_t index) const {
     uint64_t current_sum = 0;
     std::vector<uint64_t> result;
 
@@ -96,9 +96,9 @@ std::vector<uint64_t> TimelineIndex::temporal_sum_original(uint16_t index) {
         auto events = version_map.get_events(i);
         for(auto& event : events) {
             if(event.type == EventType::INSERT) {
-                current_sum += table.tuples[event.row_id].first[index];
+                current_sum += table.row(event.row_id)[index];
             } else if(event.type == EventType::DELETE) {
-                current_sum -= table.tuples[event.row_id].first[index];
+                current_sum -= table.row(event.row_id)[index];
             }
         }
         result.push_back(current_sum);
@@ -107,14 +107,14 @@ std::vector<uint64_t> TimelineIndex::temporal_sum_original(uint16_t index) {
     return result;
 }
 
-std::vector<uint64_t> TimelineIndex::temporal_max_multiset(uint16_t index) {
+std::vector<uint64_t> TimelineIndex::temporal_max_multiset(uint16_t index) const {
     std::vector<uint64_t> result;
     std::multiset<uint64_t, std::greater<>> max_set;
 
     for(int i=0; i<version_map.current_version; i++) {
         auto events = version_map.get_events(i);
         for(auto& event: events) {
-            auto inserting_value = table.tuples[event.row_id].first[index];
+            auto inserting_value = table.row(event.row_id)[index];
 
             if(event.type == EventType::INSERT) {
                 max_set.insert(inserting_value);
@@ -130,7 +130,7 @@ std::vector<uint64_t> TimelineIndex::temporal_max_multiset(uint16_t index) {
 }
 
 
-std::vector<uint64_t> TimelineIndex::temporal_max_hashmap(uint16_t index) {
+std::vector<uint64_t> TimelineIndex::temporal_max_hashmap(uint16_t index) const {
     std::vector<uint64_t> result;
     std::multiset<uint64_t, std::greater<>> max_set;
     const uint16_t k = 100;
@@ -144,7 +144,7 @@ std::vector<uint64_t> TimelineIndex::temporal_max_hashmap(uint16_t index) {
         auto events = version_map.get_events(i);
         for(auto& event : events) {
 
-            auto inserting_value = table.tuples[event.row_id].first[index];
+            auto inserting_value = table.row(event.row_id)[index];
             auto smallest_element = max_set.empty() ? 0 : get_min_element_legacy(max_set);
 
             if(event.type == EventType::INSERT) {
@@ -204,7 +204,7 @@ std::vector<uint64_t> TimelineIndex::temporal_max_hashmap(uint16_t index) {
 
 
 
-std::pair<version, checkpoint> TimelineIndex::find_earlier_checkpoint(version query_version) {
+std::pair<version, checkpoint> TimelineIndex::find_earlier_checkpoint(version query_version) const {
     if(checkpoints.empty()) {
         // used for joined index
         return {0, checkpoint()};
@@ -213,23 +213,21 @@ std::pair<version, checkpoint> TimelineIndex::find_earlier_checkpoint(version qu
         throw std::invalid_argument("Version does not exist");
     }
 
-    std::pair search_val{query_version, checkpoint()};
-
-    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), search_val,
-        [](auto x, auto y) -> bool {return x.first < y.first;});
+    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), query_version,
+        [](version x, const auto& y) -> bool {return x < y.first;});
 
     --it;
     return *it;
 }
 
 
-std::vector<Tuple> TimelineIndex::time_travel_original(uint32_t version) {
-    auto last_checkpoint = find_earlier_checkpoint(version);
+std::vector<Tuple> TimelineIndex::time_travel_original(version query_version) const {
+    auto last_checkpoint = find_earlier_checkpoint(query_version);
     auto last_checkpoint_version = last_checkpoint.first;
     auto bitset = last_checkpoint.second;
 
 
-    auto events = version_map.get_events( last_checkpoint_version + 1, version + 1);
+    auto events = version_map.get_events( last_checkpoint_version + 1, query_version + 1);
 
     for(auto& event : events) {
         if(event.type == EventType::INSERT) {
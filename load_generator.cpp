@@ -0,0 +1,116 @@
+#include "QueryClient.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#define DIFF_DISTANCE 100
+#define ROLLUP_WIDTH 100 // versions per bucket of the rollup aggregate
+
+
+struct LoadResult {
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    std::vector<uint64_t> latencies;
+};
+
+/**
+ * @brief Sends requests requests on one connection, keeping up to depth of them in flight
+ */
+template<typename Send>
+LoadResult run_client(const std::string& socket_path, uint64_t requests, uint64_t depth, Send send) {
+    QueryClient client(socket_path);
+    LoadResult result;
+    result.latencies.reserve(requests);
+    std::unordered_map<uint32_t, std::chrono::high_resolution_clock::time_point> sent;
+
+    uint64_t sent_amount = 0;
+    while(result.requests < requests) {
+        while(sent_amount < requests && sent.size() < depth) {
+            auto start = std::chrono::high_resolution_clock::now();
+            sent.emplace(send(client, sent_amount), start);
+            ++sent_amount;
+        }
+
+        auto response = client.receive();
+        auto end = std::chrono::high_resolution_clock::now();
+        auto it = sent.find(response.request_id);
+        result.latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(end - it->second).count());
+        sent.erase(it);
+        result.errors += response.status != Status::OK;
+        ++result.requests;
+    }
+    return result;
+}
+
+template<typename Send>
+void benchmark(const std::string& name, const std::string& socket_path, uint64_t requests, uint64_t depth, uint32_t clients, Send send) {
+    std::vector<LoadResult> results(clients);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for(uint32_t i=0; i<clients; i++) {
+        threads.emplace_back([&, i] {results[i] = run_client(socket_path, requests / clients, depth, send);});
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::vector<uint64_t> latencies;
+    uint64_t answered = 0;
+    uint64_t errors = 0;
+    for(auto& result : results) {
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        answered += result.requests;
+        errors += result.errors;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {return latencies.empty() ? 0 : latencies[std::min<uint64_t>(latencies.size() * p, latencies.size() - 1)];};
+    auto duration = std::max<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end-start).count(), 1);
+
+    std::cout << std::left << std::setw(14) << name << std::right << std::setw(12) << answered * 1'000'000ull / duration
+              << std::setw(12) << percentile(0.5) << std::setw(12) << percentile(0.99) << std::setw(10) << errors << std::endl;
+}
+
+// usage: TimelineIndexLoadGenerator [socket path] [requests] [pipeline depth] [clients]
+int main(int argc, char** argv) {
+    std::string socket_path = argc > 1 ? argv[1] : "/tmp/timeline_index.sock";
+    uint64_t requests = argc > 2 ? std::stoull(argv[2]) : 1000;
+    uint64_t depth = argc > 3 ? std::stoull(argv[3]) : 16;
+    uint32_t clients = argc > 4 ? std::stoul(argv[4]) : 1;
+
+    // the series of an aggregate has one value per version
+    version versions;
+    {
+        QueryClient client(socket_path);
+        client.send_aggregate(AggregateType::SUM, 0);
+        versions = client.receive().values().size();
+    }
+    if(versions <= DIFF_DISTANCE) {
+        std::cerr << "The index needs more than " << DIFF_DISTANCE << " versions" << std::endl;
+        return 1;
+    }
+
+    std::cout << requests << " requests per query type, pipeline depth " << depth << ", " << clients << " clients\n\n";
+    std::cout << "Query         requests/s   p50 in us   p99 in us    errors" << std::endl;
+    benchmark("Time Travel", socket_path, requests, depth, clients, [&](QueryClient& client, uint64_t i) {
+        return client.send_time_travel((i * 7919) % versions, {0});
+    });
+    benchmark("Diff", socket_path, requests, depth, clients, [&](QueryClient& client, uint64_t i) {
+        version from_version = (i * 7919) % (versions - DIFF_DISTANCE);
+        return client.send_diff(from_version, from_version + DIFF_DISTANCE);
+    });
+    // aggregates cover the whole history, far fewer of them
+    benchmark("Temporal Sum", socket_path, std::max<uint64_t>(requests / 100, clients), depth, clients, [&](QueryClient& client, uint64_t) {
+        return client.send_aggregate(AggregateType::SUM, 0);
+    });
+    benchmark("Sum Rollup", socket_path, std::max<uint64_t>(requests / 100, clients), depth, clients, [&](QueryClient& client, uint64_t) {
+        return client.send_aggregate_rollup(AggregateType::SUM, 0, ROLLUP_WIDTH);
+    });
+    return 0;
+}
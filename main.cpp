@@ -3,37 +3,43 @@
 //
 #include "TemporalTable.h"
 #include "TimelineIndex.h"
+#include "KeyIndex.h"
+#include "QueryExecutor.h"
+#include "EventExporter.h"
+#include "TableLoader.h"
+#include "ShardedIndex.h"
+#include "BenchmarkTables.h"
+#include "QueryServer.h"
+#include "QueryClient.h"
+#include "DistinctCounter.h"
+#include <array>
 #include <iostream>
 #include <chrono>
 #include <random>
 #include <cassert>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
 #include <iomanip>
+#include <numeric>
+#include <thread>
+#include <set>
 
-#define TEMPORAL_TABLE_SIZE 3'40'00
-#define DISTINCT_VALUES 100'000ull
-#define LIFETIME 10000 // determines how long a tuple lives, implicitly also determines the number of tuples that are still active
-#define NUMBER_OF_VERSIONS 2'20'00
 #define ITERATIONS 100
+#define WIDE_COLUMNS 16
 
 
 
 
-LifeSpan generate_life_span() {
-    uint32_t start = std::rand() % (NUMBER_OF_VERSIONS-1);
-    uint32_t life_span = std::rand() % LIFETIME + 1;
-    uint32_t end = start + life_span;
 
-    LifeSpan result{start, end};
-    if(end >= NUMBER_OF_VERSIONS) result.end = std::nullopt;
-
-    return result;
-}
-
-void init_random_temporal_table(TemporalTable& table) {
+void init_wide_temporal_table(TemporalTable& table) {
+    std::array<uint64_t, WIDE_COLUMNS> values;
     for (int i=0; i<TEMPORAL_TABLE_SIZE; ++i) {
-        Tuple tuple{std::rand() % DISTINCT_VALUES + 1};
+        for(auto& value : values) {
+            value = std::rand() % DISTINCT_VALUES + 1;
+        }
         LifeSpan lifespan = generate_life_span();
-        table.tuples.emplace_back(tuple, lifespan);
+        table.append_row(values, lifespan);
     }
 }
 
@@ -58,7 +64,7 @@ void init_descending_temporal_table(TemporalTable& table) {
     }
 }
 
-uint64_t time_travel_benchmark(TimelineIndex& index, TemporalTable& table, std::vector<Tuple> (TimelineIndex::*func)(uint32_t)) {
+uint64_t time_travel_benchmark(TimelineIndex& index, TemporalTable& table, std::vector<Tuple> (TimelineIndex::*func)(version) const) {
     uint64_t sum = 0;
 
     for(int i=0; i<ITERATIONS; i++) {
@@ -77,7 +83,487 @@ uint64_t time_travel_benchmark(TimelineIndex& index, TemporalTable& table, std::
     return sum/ITERATIONS;
 }
 
-uint64_t temporal_sum_benchmark(TimelineIndex& index, TemporalTable& table, std::vector<uint64_t> (TimelineIndex::*func)(uint16_t)) {
+uint64_t filtered_time_travel_benchmark(TimelineIndex& index, TemporalTable& table, const std::vector<Predicate>& predicates) {
+    uint64_t sum = 0;
+
+    for(int i=0; i<ITERATIONS; i++) {
+        auto traveling_version = i * NUMBER_OF_VERSIONS/ITERATIONS;
+        auto start = std::chrono::high_resolution_clock::now();
+        auto index_travel = index.time_travel_filtered(traveling_version, predicates);
+        auto end = std::chrono::high_resolution_clock::now();
+        sum += std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+
+#ifdef DEBUG
+        auto table_travel = table.time_travel(traveling_version);
+        std::erase_if(table_travel, [&](const Tuple& tuple) {
+            return !std::all_of(predicates.begin(), predicates.end(), [&](const Predicate& predicate) {return predicate.matches(tuple[predicate.index]);});
+        });
+        assert(index_travel == table_travel);
+#endif
+    }
+
+    return sum/ITERATIONS;
+}
+
+uint64_t projected_time_travel_benchmark(TimelineIndex& index, TemporalTable& table, const std::vector<uint16_t>& projection) {
+    uint64_t sum = 0;
+
+    for(int i=0; i<ITERATIONS; i++) {
+        auto traveling_version = i * NUMBER_OF_VERSIONS/ITERATIONS;
+        auto start = std::chrono::high_resolution_clock::now();
+        auto index_travel = index.time_travel_projected(traveling_version, projection);
+        auto end = std::chrono::high_resolution_clock::now();
+        sum += std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+
+#ifdef DEBUG
+        auto table_travel = table.time_travel(traveling_version);
+        assert(index_travel.row_ids.size() == table_travel.size());
+        for(uint64_t column=0; column<projection.size(); column++) {
+            for(uint64_t row=0; row<table_travel.size(); row++) {
+                assert(index_travel.columns[column][row] == table_travel[row][projection[column]]);
+            }
+        }
+#endif
+    }
+
+    return sum/ITERATIONS;
+}
+
+uint64_t multi_aggregate_benchmark(TimelineIndex& index, TemporalTable& table, const std::vector<AggregateSpec>& aggregates) {
+    auto start = std::chrono::high_resolution_clock::now();
+    auto index_aggregates = index.temporal_aggregates(aggregates);
+    auto end = std::chrono::high_resolution_clock::now();
+
+#ifdef DEBUG
+    for(uint64_t i=0; i<aggregates.size(); i++) {
+        auto& [type, column] = aggregates[i];
+        assert(index_aggregates[i] == (type == AggregateType::SUM ? table.temporal_sum(column) : table.temporal_max(column)));
+    }
+#endif
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+}
+
+uint64_t separate_aggregates_benchmark(TimelineIndex& index, const std::vector<AggregateSpec>& aggregates) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for(auto& [type, column] : aggregates) {
+        if(type == AggregateType::SUM) {
+            index.temporal_sum(column);
+        } else {
+            index.temporal_max(column);
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+}
+
+uint64_t typed_sum_benchmark(TimelineIndex& index, TemporalTable& table, uint16_t typed_column) {
+    auto start = std::chrono::high_resolution_clock::now();
+    auto index_sum = index.temporal_sum_typed(typed_column);
+    auto end = std::chrono::high_resolution_clock::now();
+
+#ifdef DEBUG
+    auto table_sum = table.temporal_sum_typed(typed_column);
+    if(std::holds_alternative<std::vector<double>>(table_sum)) {
+        // incremental floating point sums collect rounding errors
+        auto& a = std::get<std::vector<double>>(index_sum);
+        auto& b = std::get<std::vector<double>>(table_sum);
+        for(uint64_t i=0; i<a.size(); i++) {
+            assert(std::abs(a[i] - b[i]) <= 1e-9 * std::max(1.0, std::abs(b[i])));
+        }
+    } else {
+        assert(index_sum == table_sum);
+    }
+#endif
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+}
+
+uint64_t diff_benchmark(TimelineIndex& index, TemporalTable& table, uint32_t distance) {
+    uint64_t sum = 0;
+
+    for(int i=0; i<ITERATIONS; i++) {
+        uint32_t from_version = i * (NUMBER_OF_VERSIONS - distance)/ITERATIONS;
+        auto start = std::chrono::high_resolution_clock::now();
+        auto index_diff = index.diff(from_version, from_version + distance);
+        auto end = std::chrono::high_resolution_clock::now();
+        sum += std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+
+#ifdef DEBUG
+        auto alive = [&](row_id_type row_id, uint32_t version) {
+            auto& lifespan = table.tuples[row_id].second;
+            return lifespan.start <= version && (!lifespan.end.has_value() || lifespan.end.value() > version);
+        };
+        VersionDiff table_diff;
+        for(row_id_type row_id=0; row_id<table.get_table_size(); row_id++) {
+            bool before = alive(row_id, from_version);
+            bool after = alive(row_id, from_version + distance);
+            if(!before && after) table_diff.inserted.push_back(row_id);
+            if(before && !after) table_diff.deleted.push_back(row_id);
+        }
+        assert(index_diff.inserted == table_diff.inserted && index_diff.deleted == table_diff.deleted);
+#endif
+    }
+
+    return sum/ITERATIONS;
+}
+
+uint64_t export_benchmark(TimelineIndex& index, TemporalTable& table, uint64_t batch_size) {
+    uint64_t events = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    EventExporter exporter(index, 0, NUMBER_OF_VERSIONS, {0}, batch_size);
+    while(auto batch = exporter.next()) {
+#ifdef DEBUG
+        for(uint64_t i=0; i<batch->length; i++) {
+            auto& lifespan = table.tuples[batch->row_ids[i]].second;
+            if(batch->types[i] == 0) assert(lifespan.start == batch->versions[i]);
+            else assert(lifespan.end.value() == batch->versions[i]);
+            assert(batch->columns[0][i] == table.row(batch->row_ids[i])[0]);
+        }
+#endif
+
+        events += batch->length;
+        exporter.recycle(std::move(*batch));
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    assert(events == table.get_number_of_events());
+
+#ifdef DEBUG // a missing projected column leaves the batch untouched
+    EventBatch batch;
+    try {
+        index.export_events({0, 0}, NUMBER_OF_VERSIONS, {0, 1}, batch_size, batch);
+        assert(false);
+    } catch(std::invalid_argument&) {}
+    assert(batch.length == 0 && batch.row_ids.size() == 0 && batch.columns.empty());
+#endif
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+}
+
+uint64_t bulk_load_benchmark(const std::string& path, FileFormat format, uint32_t threads, TemporalTable& table) {
+    TemporalTable loaded_table(NUMBER_OF_VERSIONS, 0);
+    auto start = std::chrono::high_resolution_clock::now();
+    TableLoader(path, format, threads).load(loaded_table);
+    auto end = std::chrono::high_resolution_clock::now();
+
+#ifdef DEBUG
+    assert(loaded_table.get_table_size() == table.get_table_size());
+    for(row_id_type row_id=0; row_id<table.get_table_size(); row_id++) {
+        auto loaded_row = loaded_table.row(row_id);
+        auto row = table.row(row_id);
+        assert(std::equal(loaded_row.begin(), loaded_row.end(), row.begin(), row.end()));
+        assert(loaded_table.tuples[row_id].second.start == table.tuples[row_id].second.start);
+        assert(loaded_table.tuples[row_id].second.end == table.tuples[row_id].second.end);
+    }
+#endif
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+}
+
+uint64_t count_distinct_benchmark(TimelineIndex& index, TemporalTable& table, bool approximate) {
+    auto start = std::chrono::high_resolution_clock::now();
+    auto index_count = index.temporal_count_distinct(0, approximate);
+    auto end = std::chrono::high_resolution_clock::now();
+
+#ifdef DEBUG
+    auto table_count = table.temporal_count_distinct(0);
+    if(approximate) {
+        for(uint64_t i=0; i<table_count.size(); i++) {
+            assert(std::abs(static_cast<double>(index_count[i]) - static_cast<double>(table_count[i])) <= 0.1 * table_count[i] + 2);
+        }
+    } else {
+        assert(index_count == table_count);
+    }
+    try {
+        index.temporal_count_distinct(1, approximate);
+        assert(false);
+    } catch(std::invalid_argument&) {}
+
+    // the full range of uint64_t does not fit a dense array
+    ExactDistinctCounter counter(0, UINT64_MAX, 2);
+    counter.insert(0);
+    counter.insert(UINT64_MAX);
+    counter.insert(UINT64_MAX);
+    assert(counter.count() == 2);
+    counter.remove(0);
+    assert(counter.count() == 1);
+#endif
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+}
+
+uint64_t quantile_benchmark(TimelineIndex& index, TemporalTable& table, const std::vector<double>& quantiles) {
+    auto start = std::chrono::high_resolution_clock::now();
+    auto index_quantiles = index.temporal_quantiles(0, quantiles);
+    auto end = std::chrono::high_resolution_clock::now();
+
+#ifdef DEBUG
+    auto table_quantiles = table.temporal_quantiles(0, quantiles);
+    assert(index_quantiles == table_quantiles);
+    try {
+        index.temporal_quantiles(1, quantiles);
+        assert(false);
+    } catch(std::invalid_argument&) {}
+#endif
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+}
+
+uint64_t top_k_benchmark(TimelineIndex& index, TemporalTable& table, uint32_t k) {
+    auto start = std::chrono::high_resolution_clock::now();
+    auto index_top_k = index.temporal_top_k(0, k);
+    auto end = std::chrono::high_resolution_clock::now();
+
+#ifdef DEBUG
+    auto table_top_k = table.temporal_top_k(0, k);
+    std::set<row_id_type> current_top;
+    for(uint32_t i=0; i<table_top_k.size(); i++) {
+        for(auto& event : index_top_k.changes(i)) {
+            if(event.type == EventType::INSERT) {
+                current_top.insert(event.row_id);
+            } else {
+                current_top.erase(event.row_id);
+            }
+        }
+        assert(std::vector<row_id_type>(current_top.begin(), current_top.end()) == table_top_k[i]);
+    }
+    try {
+        index.temporal_top_k(1, k);
+        assert(false);
+    } catch(std::invalid_argument&) {}
+#endif
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+}
+
+uint64_t async_time_travel_benchmark(TimelineIndex& index, TemporalTable& table) {
+    QueryExecutor executor(index);
+    std::vector<std::future<std::vector<Tuple>>> results;
+
+    // clustered load, every iteration asks for a few versions right after each other
+    auto start = std::chrono::high_resolution_clock::now();
+    for(int i=0; i<ITERATIONS; i++) {
+        auto traveling_version = (i % 10) * NUMBER_OF_VERSIONS/10 + i;
+        results.push_back(executor.submit_time_travel(traveling_version));
+    }
+    for(auto& result : results) {
+        result.wait();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+#ifdef DEBUG
+    for(int i=0; i<ITERATIONS; i++) {
+        auto traveling_version = (i % 10) * NUMBER_OF_VERSIONS/10 + i;
+        assert(results[i].get() == table.time_travel(traveling_version));
+    }
+
+    // an aggregate on a missing column only fails its own request, not the valid one batched with it
+    auto invalid_aggregate = executor.submit_aggregate(AggregateType::MAX, 1);
+    auto valid_aggregate = executor.submit_aggregate(AggregateType::SUM, 0);
+    assert(valid_aggregate.get() == table.temporal_sum(0));
+    try {
+        invalid_aggregate.get();
+        assert(false);
+    } catch(std::invalid_argument&) {}
+#endif
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count()/ITERATIONS;
+}
+
+uint64_t concurrent_time_travel_benchmark(const TimelineIndex& index, const TemporalTable& table, uint32_t clients) {
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for(uint32_t client=0; client<clients; client++) {
+        threads.emplace_back([&index, &table, client, clients] {
+            for(uint32_t i=client; i<ITERATIONS; i+=clients) {
+                auto traveling_version = i * NUMBER_OF_VERSIONS/ITERATIONS;
+                auto index_travel = index.time_travel(traveling_version);
+#ifdef DEBUG
+                assert(index_travel == table.time_travel(traveling_version));
+#endif
+            }
+        });
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // queries per second
+    return ITERATIONS * 1'000'000ull / std::max<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end-start).count(), 1);
+}
+
+uint64_t query_server_benchmark(TemporalTable& table) {
+    // appends change the index, so the server gets its own
+    TimelineIndex index(table);
+    auto socket_path = (std::filesystem::temp_directory_path() / "timeline_index_benchmark.sock").string();
+    QueryServer server(index, socket_path);
+    QueryClient client(socket_path);
+    uint64_t sum = 0;
+
+    for(int i=0; i<ITERATIONS; i++) {
+        auto traveling_version = i * NUMBER_OF_VERSIONS/ITERATIONS;
+        auto start = std::chrono::high_resolution_clock::now();
+        client.send_time_travel(traveling_version, {0});
+        auto response = client.receive();
+        auto end = std::chrono::high_resolution_clock::now();
+        sum += std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+
+#ifdef DEBUG
+        auto index_travel = index.time_travel_projected(traveling_version, {0});
+        auto values = response.values();
+        assert(response.status == Status::OK && values[0] == index_travel.row_ids.size() && values[1] == 1);
+        assert(std::equal(index_travel.columns[0].begin(), index_travel.columns[0].end(), values.begin() + 2));
+#endif
+    }
+
+#ifdef DEBUG
+    client.send_aggregate(AggregateType::MAX, 0);
+    assert(client.receive().values() == index.temporal_max(0));
+    client.send_aggregate_rollup(AggregateType::SUM, 0, 100);
+    assert(client.receive().buckets() == index.temporal_sum_rollup(0, 100));
+
+    client.send_diff(100, 200);
+    auto response = client.receive();
+    auto diff = index.diff(100, 200);
+    auto counts = response.values();
+    decltype(diff.inserted) inserted(counts[0]);
+    decltype(diff.deleted) deleted(counts[1]);
+    std::memcpy(inserted.data(), response.payload.data() + 2 * sizeof(uint64_t), inserted.size() * sizeof(inserted[0]));
+    std::memcpy(deleted.data(), response.payload.data() + 2 * sizeof(uint64_t) + inserted.size() * sizeof(inserted[0]), deleted.size() * sizeof(deleted[0]));
+    assert(inserted == diff.inserted && deleted == diff.deleted);
+
+    // a version after the latest one and a column the rows do not have
+    client.send_time_travel(NUMBER_OF_VERSIONS, {0});
+    response = client.receive();
+    assert(response.status == Status::ERROR && !response.message().empty());
+    client.send_aggregate(AggregateType::SUM, 1);
+    assert(client.receive().status == Status::ERROR);
+
+    row_id_type deleted_row = 0;
+    while(table.tuples[deleted_row].second.end.has_value()) ++deleted_row;
+    client.send_append({Event(deleted_row, NO_ROW, EventType::DELETE)});
+    response = client.receive();
+    assert(response.status == Status::OK && response.values()[0] == NUMBER_OF_VERSIONS);
+    auto append_diff = index.diff(NUMBER_OF_VERSIONS - 1, NUMBER_OF_VERSIONS);
+    assert(append_diff.inserted.empty() && append_diff.deleted.size() == 1 && append_diff.deleted[0] == deleted_row);
+#endif
+
+    server.stop();
+    return sum/ITERATIONS;
+}
+
+uint64_t sharded_time_travel_benchmark(const ShardedIndex& index, const TemporalTable& table, ShardPartitioning partitioning) {
+    uint64_t sum = 0;
+
+    for(int i=0; i<ITERATIONS; i++) {
+        auto traveling_version = i * NUMBER_OF_VERSIONS/ITERATIONS;
+        auto start = std::chrono::high_resolution_clock::now();
+        auto index_travel = index.time_travel(traveling_version);
+        auto end = std::chrono::high_resolution_clock::now();
+        sum += std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+
+#ifdef DEBUG // row ranges keep the order of the single index, key hashing only the rows
+        auto table_travel = table.time_travel(traveling_version);
+        if(partitioning == ShardPartitioning::KEY_HASH) {
+            std::sort(index_travel.begin(), index_travel.end());
+            std::sort(table_travel.begin(), table_travel.end());
+        }
+        assert(index_travel == table_travel);
+#endif
+    }
+
+    return sum/ITERATIONS;
+}
+
+uint64_t sharded_temporal_sum_benchmark(const ShardedIndex& index, const TemporalTable& table) {
+    auto start = std::chrono::high_resolution_clock::now();
+    auto index_sum = index.temporal_sum(0);
+    auto end = std::chrono::high_resolution_clock::now();
+
+#ifdef DEBUG
+    assert(index_sum == table.temporal_sum(0));
+    auto table_max = table.temporal_max(0);
+    assert(index.temporal_max(0) == table_max);
+    auto aggregates = index.temporal_aggregates({{AggregateType::SUM, 0}, {AggregateType::MAX, 0}});
+    assert(aggregates.size() == 2 && aggregates[0] == index_sum && aggregates[1] == table_max);
+#endif
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+}
+
+#ifdef DEBUG
+// appended versions are routed to the shards of their rows, shards without rows still count the versions
+void sharded_append_check(TemporalTable& table) {
+    ShardedIndex sharded_index(table, 4, ShardPartitioning::KEY_HASH);
+    TimelineIndex single_index(table);
+
+    std::vector<Event> events;
+    for(row_id_type row_id = 0; events.size() < 16; ++row_id) {
+        if(!table.tuples[row_id].second.end.has_value()) events.emplace_back(row_id, NO_ROW, EventType::DELETE);
+    }
+    // a query running during the append sees the new version on all shards or on none of them
+    std::vector<AggregateSpec> aggregates{{AggregateType::SUM, 0}, {AggregateType::MAX, 0}};
+    std::thread query([&] {
+        auto series = sharded_index.temporal_aggregates(aggregates);
+        assert(series[0].size() == NUMBER_OF_VERSIONS || series[0].size() == NUMBER_OF_VERSIONS + 1);
+    });
+    sharded_index.append_version(events);
+    single_index.append_version(events);
+    query.join();
+
+    auto sharded_travel = sharded_index.time_travel(NUMBER_OF_VERSIONS);
+    auto single_travel = single_index.time_travel(NUMBER_OF_VERSIONS);
+    std::sort(sharded_travel.begin(), sharded_travel.end());
+    std::sort(single_travel.begin(), single_travel.end());
+    assert(sharded_travel.size() + events.size() == table.time_travel(NUMBER_OF_VERSIONS - 1).size());
+    assert(sharded_travel == single_travel);
+    assert(sharded_index.temporal_aggregates(aggregates) == single_index.temporal_aggregates(aggregates));
+
+    // three rows on eight shards leave five shards empty, the rows are alive at the latest version
+    TemporalTable small_table(NUMBER_OF_VERSIONS, 3);
+    for(uint32_t i = 0; i < 3; ++i) {
+        small_table.tuples.emplace_back(table.tuples[events[i].row_id]);
+    }
+    ShardedIndex small_sharded_index(small_table, 8);
+    TimelineIndex small_single_index(small_table);
+    std::vector<Event> small_events{Event(0, NO_ROW, EventType::DELETE)};
+    small_sharded_index.append_version(small_events);
+    small_single_index.append_version(small_events);
+    for(version query_version : {version(0), version(NUMBER_OF_VERSIONS / 2), version(NUMBER_OF_VERSIONS)}) {
+        assert(small_sharded_index.time_travel(query_version) == small_single_index.time_travel(query_version));
+    }
+    assert(small_sharded_index.temporal_aggregates(aggregates) == small_single_index.temporal_aggregates(aggregates));
+}
+#endif
+
+uint64_t key_lookup_benchmark(KeyIndex& key_index, TemporalTable& table) {
+    uint64_t sum = 0;
+
+    for(int i=0; i<ITERATIONS; i++) {
+        auto traveling_version = i * NUMBER_OF_VERSIONS/ITERATIONS;
+        uint64_t key = table.tuples[i * table.get_table_size()/ITERATIONS].first[0];
+        auto start = std::chrono::high_resolution_clock::now();
+        auto index_travel = key_index.time_travel(key, traveling_version);
+        auto end = std::chrono::high_resolution_clock::now();
+        sum += std::chrono::duration_cast<std::chrono::nanoseconds>(end-start).count();
+
+#ifdef DEBUG
+        auto table_travel = table.time_travel(traveling_version);
+        std::erase_if(table_travel, [&](const Tuple& tuple) {return tuple[0] != key;});
+        std::sort(index_travel.begin(), index_travel.end());
+        std::sort(table_travel.begin(), table_travel.end());
+        assert(index_travel == table_travel);
+#endif
+    }
+
+    return sum/ITERATIONS;
+}
+
+uint64_t temporal_sum_benchmark(TimelineIndex& index, TemporalTable& table, std::vector<uint64_t> (TimelineIndex::*func)(uint16_t) const) {
     auto start = std::chrono::high_resolution_clock::now();
     auto index_sum = (index.*func)(0);
     auto end = std::chrono::high_resolution_clock::now();
@@ -91,7 +577,7 @@ uint64_t temporal_sum_benchmark(TimelineIndex& index, TemporalTable& table, std:
 
 }
 
-uint64_t temporal_max_benchmark(TimelineIndex& index, TemporalTable& table, std::vector<uint64_t> (TimelineIndex::*func)(uint16_t)) {
+uint64_t temporal_max_benchmark(TimelineIndex& index, TemporalTable& table, std::vector<uint64_t> (TimelineIndex::*func)(uint16_t) const) {
     auto start = std::chrono::high_resolution_clock::now();
     auto index_max = (index.*func)(0);
     auto end = std::chrono::high_resolution_clock::now();
@@ -104,6 +590,26 @@ uint64_t temporal_max_benchmark(TimelineIndex& index, TemporalTable& table, std:
     return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
 }
 
+uint64_t rollup_benchmark(TimelineIndex& index, TemporalTable& table, AggregateType type, version bucket_width) {
+    auto start = std::chrono::high_resolution_clock::now();
+    auto buckets = type == AggregateType::SUM ? index.temporal_sum_rollup(0, bucket_width) : index.temporal_max_rollup(0, bucket_width);
+    auto end = std::chrono::high_resolution_clock::now();
+
+#ifdef DEBUG
+    auto series = type == AggregateType::SUM ? table.temporal_sum(0) : table.temporal_max(0);
+    assert(buckets.size() == (series.size() + bucket_width - 1) / bucket_width);
+    for(uint64_t i=0; i<buckets.size(); i++) {
+        auto first = series.begin() + i * bucket_width;
+        auto last = series.begin() + std::min<uint64_t>((i+1) * bucket_width, series.size());
+        auto [min, max] = std::minmax_element(first, last);
+        assert(buckets[i].min == *min && buckets[i].max == *max && buckets[i].last == *(last-1));
+        assert(std::abs(buckets[i].avg - std::accumulate(first, last, 0.0) / (last - first)) <= 1e-9 * std::max(1.0, buckets[i].avg));
+    }
+#endif
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+}
+
 uint64_t temporal_join_benchmark(TimelineIndex& index, TimelineIndex& index2, TemporalTable& main_table, TemporalTable& second_table) {
     auto start = std::chrono::high_resolution_clock::now();
     auto index_join = index.temporal_join(index2);
@@ -122,6 +628,19 @@ uint64_t temporal_join_benchmark(TimelineIndex& index, TimelineIndex& index2, Te
     return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
 }
 
+uint64_t temporal_join_sum_benchmark(TimelineIndex& index, TimelineIndex& index2, TemporalTable& main_table, TemporalTable& second_table) {
+    auto start = std::chrono::high_resolution_clock::now();
+    auto index_join_sum = index.temporal_join_sum(index2, 0);
+    auto end = std::chrono::high_resolution_clock::now();
+
+#ifdef DEBUG
+    auto table_join_sum = main_table.temporal_join(second_table, 0).temporal_sum(0);
+    assert(index_join_sum == table_join_sum);
+#endif
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+}
+
 
 int main() {
 
@@ -155,6 +674,16 @@ int main() {
     std::cout << std::chrono::duration_cast<std::chrono::microseconds>(end-start).count()/4 << std::endl;
     std::cout << std::endl;
 
+    auto memory = index.memory_usage();
+    std::cout << "Memory usage of the random index in bytes, " << 8 * sizeof(version) << " bit versions and row ids, " << sizeof(Event) << " bytes per event: " << std::endl;
+    std::cout << "Events:       " << std::setw(12) << memory.version_map.events << std::endl;
+    std::cout << "Versions:     " << std::setw(12) << memory.version_map.versions << std::endl;
+    std::cout << "Checkpoints:  " << std::setw(12) << memory.checkpoints_total() << " (" << memory.checkpoints.size() << " checkpoints)" << std::endl;
+    std::cout << "Table tuples: " << std::setw(12) << memory.table.tuples << std::endl;
+    std::cout << "Table rows:   " << std::setw(12) << memory.table.rows << std::endl;
+    std::cout << "Zone maps:    " << std::setw(12) << memory.table.zone_maps << std::endl;
+    std::cout << std::endl;
+
 // ----------------------------------------------------------------
 
 
@@ -171,11 +700,243 @@ int main() {
     auto descending_main_travel = time_travel_benchmark(descending_index, descending_table, &TimelineIndex::time_travel);
     auto descending_original_travel = time_travel_benchmark(descending_index, descending_table, &TimelineIndex::time_travel_original);
 
+    // the second pass over the same versions is answered from the snapshot cache
+    index.set_snapshot_cache_budget(SNAPSHOT_CACHE_BUDGET);
+#ifdef DEBUG // the seeds of the aggregate threads are not cached
+    index.temporal_sum(0);
+    assert(index.memory_usage().snapshot_cache == 0);
+#endif
+    time_travel_benchmark(index, main_table, &TimelineIndex::time_travel);
+    auto random_cached_travel = time_travel_benchmark(index, main_table, &TimelineIndex::time_travel);
+    index.set_snapshot_cache_budget(0);
+
 
     std::cout << "                  Modified Time Travel      Original Time Travel" << std::endl;
     std::cout << "Random values:      " << std::setw(8) << random_main_travel << "               " << std::setw(8) << random_original_travel << std::endl;
     std::cout << "Ascending values:   " << std::setw(8) << ascending_main_travel << "               " << std::setw(8) << ascending_original_travel << std::endl;
     std::cout << "Descending values:  " << std::setw(8) << descending_main_travel << "               " << std::setw(8) << descending_original_travel << std::endl;
+    std::cout << "Random cached:      " << std::setw(8) << random_cached_travel << std::endl;
+    std::cout << "Random async:       " << std::setw(8) << async_time_travel_benchmark(index, main_table) << std::endl;
+    std::cout << std::endl;
+
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Diff ---------------------------
+    std::cout << "Diff testing on random values, average on " << ITERATIONS << " iterations\n\n";
+    std::cout << "Two time travels:   " << std::setw(8) << 2 * random_main_travel << std::endl;
+    for(uint32_t distance : {1, 10, 100, 1000}) {
+        std::cout << std::setw(4) << distance << " versions:      " << std::setw(8) << diff_benchmark(index, main_table, distance) << std::endl;
+    }
+    std::cout << std::endl;
+
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Event Export ------------------
+    std::cout << "Event Export testing, full history of " << main_table.get_number_of_events() << " events\n\n";
+    std::cout << "Time travel to every version (estimated): " << std::setw(12) << random_main_travel * NUMBER_OF_VERSIONS << std::endl;
+    for(uint64_t batch_size : {1 << 12, 1 << 16}) {
+        std::cout << "Export, " << std::setw(5) << batch_size << " events per batch:    " << std::setw(12) << export_benchmark(index, main_table, batch_size) << std::endl;
+    }
+    std::cout << std::endl;
+
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Concurrent Clients -------------
+    std::cout << "Concurrent Time Travel testing on one shared index, queries per second\n\n";
+    for(uint32_t clients : {1, 2, 4, 8}) {
+        std::cout << std::setw(2) << clients << " clients:         " << std::setw(8) << concurrent_time_travel_benchmark(index, main_table, clients) << std::endl;
+    }
+    std::cout << std::endl;
+
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Query Server -------------------
+    std::cout << "Query Server testing, time travel round trip over a Unix domain socket" << std::endl;
+    std::cout << "Random values:      " << std::setw(8) << query_server_benchmark(main_table) << std::endl;
+    std::cout << std::endl;
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Sharded Index ------------------
+    for(auto partitioning : {ShardPartitioning::ROW_RANGE, ShardPartitioning::KEY_HASH}) {
+        std::cout << "Sharded Index testing on random values, partitioned by "
+                  << (partitioning == ShardPartitioning::ROW_RANGE ? "row ranges" : "key hash") << "\n\n";
+        std::cout << "Shards        Construction     Time Travel    Temporal Sum" << std::endl;
+        for(uint32_t shard_amount : {1, 2, 4, 8}) {
+            start = std::chrono::high_resolution_clock::now();
+            ShardedIndex sharded_index(main_table, shard_amount, partitioning);
+            end = std::chrono::high_resolution_clock::now();
+            auto sharded_construction = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+            std::cout << std::setw(6) << shard_amount << "    " << std::setw(16) << sharded_construction
+                      << std::setw(16) << sharded_time_travel_benchmark(sharded_index, main_table, partitioning)
+                      << std::setw(16) << sharded_temporal_sum_benchmark(sharded_index, main_table) << std::endl;
+        }
+        std::cout << std::endl;
+    }
+#ifdef DEBUG
+    sharded_append_check(main_table);
+#endif
+
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Filtered Time Travel -----------
+    std::cout << "Filtered Time Travel testing (value > 99%), average on " << ITERATIONS << " iterations\n\n";
+    std::vector<Predicate> random_predicates{{0, Comparison::GREATER, DISTINCT_VALUES * 99 / 100}};
+    std::vector<Predicate> ordered_predicates{{0, Comparison::GREATER, TEMPORAL_TABLE_SIZE * 99 / 100}};
+    auto random_filtered_travel = filtered_time_travel_benchmark(index, main_table, random_predicates);
+    auto ascending_filtered_travel = filtered_time_travel_benchmark(ascending_index, ascending_table, ordered_predicates);
+    auto descending_filtered_travel = filtered_time_travel_benchmark(descending_index, descending_table, ordered_predicates);
+
+    std::cout << "Random values:      " << std::setw(8) << random_filtered_travel << std::endl;
+    std::cout << "Ascending values:   " << std::setw(8) << ascending_filtered_travel << std::endl;
+    std::cout << "Descending values:  " << std::setw(8) << descending_filtered_travel << std::endl;
+    std::cout << std::endl;
+
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Projected Time Travel ----------
+    std::cout << "Projected Time Travel testing on " << WIDE_COLUMNS << " random columns, average on " << ITERATIONS << " iterations\n\n";
+    TemporalTable wide_table(NUMBER_OF_VERSIONS, TEMPORAL_TABLE_SIZE);
+    init_wide_temporal_table(wide_table);
+    TimelineIndex wide_index(wide_table);
+    auto wide_travel = time_travel_benchmark(wide_index, wide_table, &TimelineIndex::time_travel);
+    auto wide_projected_one = projected_time_travel_benchmark(wide_index, wide_table, {0});
+    auto wide_projected_four = projected_time_travel_benchmark(wide_index, wide_table, {0, 3, 7, 11});
+
+    std::cout << "All columns:        " << std::setw(8) << wide_travel << std::endl;
+    std::cout << "Projected 1 column: " << std::setw(8) << wide_projected_one << std::endl;
+    std::cout << "Projected 4 columns:" << std::setw(8) << wide_projected_four << std::endl;
+    std::cout << std::endl;
+
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Multi Aggregates ---------------
+    std::cout << "Multi Aggregate testing, 3 sums and 2 maxima on " << WIDE_COLUMNS << " random columns\n\n";
+    std::vector<AggregateSpec> wide_aggregates{{AggregateType::SUM, 0}, {AggregateType::SUM, 1}, {AggregateType::SUM, 2},
+                                               {AggregateType::MAX, 3}, {AggregateType::MAX, 4}};
+    std::cout << "Separate passes:    " << std::setw(8) << separate_aggregates_benchmark(wide_index, wide_aggregates) << std::endl;
+    std::cout << "Single pass:        " << std::setw(8) << multi_aggregate_benchmark(wide_index, wide_table, wide_aggregates) << std::endl;
+    std::cout << std::endl;
+
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Row Arena ----------------------
+    std::cout << "Row Arena testing on " << WIDE_COLUMNS << " random columns\n\n";
+    std::srand(420);
+    start = std::chrono::high_resolution_clock::now();
+    TemporalTable vector_table(NUMBER_OF_VERSIONS, TEMPORAL_TABLE_SIZE);
+    init_wide_temporal_table(vector_table);
+    end = std::chrono::high_resolution_clock::now();
+    auto vector_load = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+
+    std::srand(420);
+    start = std::chrono::high_resolution_clock::now();
+    TemporalTable arena_table(NUMBER_OF_VERSIONS, TEMPORAL_TABLE_SIZE, WIDE_COLUMNS);
+    init_wide_temporal_table(arena_table);
+    end = std::chrono::high_resolution_clock::now();
+    auto arena_load = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+
+    TimelineIndex vector_index(vector_table);
+    TimelineIndex arena_index(arena_table);
+
+    std::cout << "                  Row Vectors       Row Arena" << std::endl;
+    std::cout << "Load:               " << std::setw(8) << vector_load << "          " << std::setw(8) << arena_load << std::endl;
+    std::cout << "Time Travel:        " << std::setw(8) << time_travel_benchmark(vector_index, vector_table, &TimelineIndex::time_travel) << "          " << std::setw(8) << time_travel_benchmark(arena_index, arena_table, &TimelineIndex::time_travel) << std::endl;
+    std::cout << "Temporal Sum:       " << std::setw(8) << temporal_sum_benchmark(vector_index, vector_table, &TimelineIndex::temporal_sum) << "          " << std::setw(8) << temporal_sum_benchmark(arena_index, arena_table, &TimelineIndex::temporal_sum) << std::endl;
+    std::cout << "Multi Aggregates:   " << std::setw(8) << multi_aggregate_benchmark(vector_index, vector_table, wide_aggregates) << "          " << std::setw(8) << multi_aggregate_benchmark(arena_index, arena_table, wide_aggregates) << std::endl;
+    std::cout << std::endl;
+
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Bulk Loading -------------------
+    std::cout << "Bulk Loading testing on the " << WIDE_COLUMNS << " random columns of the arena table\n\n";
+    auto binary_path = (std::filesystem::temp_directory_path() / "timeline_index_table.bin").string();
+    auto csv_path = (std::filesystem::temp_directory_path() / "timeline_index_table.csv").string();
+    TableLoader::write(arena_table, binary_path, FileFormat::BINARY);
+    TableLoader::write(arena_table, csv_path, FileFormat::CSV);
+
+    std::cout << "                  1 Thread        4 Threads" << std::endl;
+    std::cout << "Binary:             " << std::setw(8) << bulk_load_benchmark(binary_path, FileFormat::BINARY, 1, arena_table) << "          " << std::setw(8) << bulk_load_benchmark(binary_path, FileFormat::BINARY, 4, arena_table) << std::endl;
+    std::cout << "CSV:                " << std::setw(8) << bulk_load_benchmark(csv_path, FileFormat::CSV, 1, arena_table) << "          " << std::setw(8) << bulk_load_benchmark(csv_path, FileFormat::CSV, 4, arena_table) << std::endl;
+
+    TemporalTable loaded_table(NUMBER_OF_VERSIONS, 0);
+    auto version_histogram = TableLoader(binary_path, FileFormat::BINARY).load(loaded_table, true);
+    start = std::chrono::high_resolution_clock::now();
+    TimelineIndex counted_index(loaded_table);
+    end = std::chrono::high_resolution_clock::now();
+    auto counted_construction = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+    start = std::chrono::high_resolution_clock::now();
+    TimelineIndex histogram_index(loaded_table, version_histogram);
+    end = std::chrono::high_resolution_clock::now();
+    auto histogram_construction = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+    std::cout << "Index construction: " << std::setw(8) << counted_construction << " (counting)   " << std::setw(8) << histogram_construction << " (histogram from the load)" << std::endl;
+#ifdef DEBUG
+    for(uint32_t i=0; i<ITERATIONS; i++) {
+        assert(histogram_index.time_travel(i * NUMBER_OF_VERSIONS/ITERATIONS) == counted_index.time_travel(i * NUMBER_OF_VERSIONS/ITERATIONS));
+    }
+#endif
+    std::filesystem::remove(binary_path);
+    std::filesystem::remove(csv_path);
+    std::cout << std::endl;
+
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Typed Columns ------------------
+    std::cout << "Typed Column testing, temporal sum over the random values stored in different types\n\n";
+    std::vector<uint8_t> narrow_values;
+    std::vector<uint32_t> counter_values;
+    std::vector<double> double_values;
+    for(uint32_t i=0; i<main_table.get_table_size(); i++) {
+        auto value = main_table.row(i)[0];
+        narrow_values.push_back(value % 256);
+        counter_values.push_back(value);
+        double_values.push_back(value / 100.0);
+    }
+    auto narrow_column = main_table.add_typed_column(std::move(narrow_values));
+    auto counter_column = main_table.add_typed_column(std::move(counter_values));
+    auto double_column = main_table.add_typed_column(std::move(double_values));
+
+    std::cout << "u64 row column:     " << std::setw(8) << temporal_sum_benchmark(index, main_table, &TimelineIndex::temporal_sum) << std::endl;
+    std::cout << "u8 typed column:    " << std::setw(8) << typed_sum_benchmark(index, main_table, narrow_column) << std::endl;
+    std::cout << "u32 typed column:   " << std::setw(8) << typed_sum_benchmark(index, main_table, counter_column) << std::endl;
+    std::cout << "f64 typed column:   " << std::setw(8) << typed_sum_benchmark(index, main_table, double_column) << std::endl;
+    std::cout << "Typed column bytes: " << std::setw(8) << main_table.memory_usage().typed_columns << std::endl;
+    std::cout << std::endl;
+
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Key Lookup --------------------
+    std::cout << "Key Lookup testing in nanoseconds, average on " << ITERATIONS << " iterations\n\n";
+    KeyIndex random_key_index(main_table, 0);
+    KeyIndex ascending_key_index(ascending_table, 0);
+    KeyIndex descending_key_index(descending_table, 0);
+
+    std::cout << "Random values:      " << std::setw(8) << key_lookup_benchmark(random_key_index, main_table) << std::endl;
+    std::cout << "Ascending values:   " << std::setw(8) << key_lookup_benchmark(ascending_key_index, ascending_table) << std::endl;
+    std::cout << "Descending values:  " << std::setw(8) << key_lookup_benchmark(descending_key_index, descending_table) << std::endl;
     std::cout << std::endl;
 
 // ----------------------------------------------------------------
@@ -229,13 +990,159 @@ int main() {
 
 
 
+// ------------------ Benchmarking Rollup Aggregates --------------
+    std::cout << "Rollup Aggregate testing on random values, buckets of versions" << std::endl;
+    std::cout << "                  Width 10      Width 100     Width 1000" << std::endl;
+    std::cout << "Sum Rollup:         " << std::setw(8) << rollup_benchmark(index, main_table, AggregateType::SUM, 10) << "      " << std::setw(8) << rollup_benchmark(index, main_table, AggregateType::SUM, 100) << "      " << std::setw(8) << rollup_benchmark(index, main_table, AggregateType::SUM, 1000) << std::endl;
+    std::cout << "Max Rollup:         " << std::setw(8) << rollup_benchmark(index, main_table, AggregateType::MAX, 10) << "      " << std::setw(8) << rollup_benchmark(index, main_table, AggregateType::MAX, 100) << "      " << std::setw(8) << rollup_benchmark(index, main_table, AggregateType::MAX, 1000) << std::endl;
+    std::cout << "Output bytes:       " << std::setw(8) << (NUMBER_OF_VERSIONS + 9) / 10 * sizeof(RollupBucket) << "      " << std::setw(8) << (NUMBER_OF_VERSIONS + 99) / 100 * sizeof(RollupBucket) << "      " << std::setw(8) << (NUMBER_OF_VERSIONS + 999) / 1000 * sizeof(RollupBucket)
+              << " instead of " << NUMBER_OF_VERSIONS * sizeof(uint64_t) << std::endl;
+    std::cout << std::endl;
+    std::cout << std::endl;
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Count Distinct -----------------
+    std::cout << "Temporal Count Distinct testing" << std::endl;
+    std::cout << "                  Exact Count Distinct      Approximate Count Distinct" << std::endl;
+    std::cout << "Random values:      " << std::setw(8) << count_distinct_benchmark(index, main_table, false) << "                 " << std::setw(8) << count_distinct_benchmark(index, main_table, true) << std::endl;
+    std::cout << "Ascending values:   " << std::setw(8) << count_distinct_benchmark(ascending_index, ascending_table, false) << "                 " << std::setw(8) << count_distinct_benchmark(ascending_index, ascending_table, true) << std::endl;
+    std::cout << "Descending values:  " << std::setw(8) << count_distinct_benchmark(descending_index, descending_table, false) << "                 " << std::setw(8) << count_distinct_benchmark(descending_index, descending_table, true) << std::endl;
+    std::cout << std::endl;
+    std::cout << std::endl;
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Quantiles ----------------------
+    std::cout << "Temporal Quantile testing" << std::endl;
+    std::vector<double> median{0.5};
+    std::vector<double> slo_quantiles{0.5, 0.95, 0.99};
+    std::cout << "                  Median                    p50, p95, p99" << std::endl;
+    std::cout << "Random values:      " << std::setw(8) << quantile_benchmark(index, main_table, median) << "                 " << std::setw(8) << quantile_benchmark(index, main_table, slo_quantiles) << std::endl;
+    std::cout << "Ascending values:   " << std::setw(8) << quantile_benchmark(ascending_index, ascending_table, median) << "                 " << std::setw(8) << quantile_benchmark(ascending_index, ascending_table, slo_quantiles) << std::endl;
+    std::cout << "Descending values:  " << std::setw(8) << quantile_benchmark(descending_index, descending_table, median) << "                 " << std::setw(8) << quantile_benchmark(descending_index, descending_table, slo_quantiles) << std::endl;
+    std::cout << std::endl;
+    std::cout << std::endl;
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Top-K --------------------------
+    std::cout << "Temporal Top-K testing" << std::endl;
+    std::cout << "                  Top 10                    Top 100" << std::endl;
+    std::cout << "Random values:      " << std::setw(8) << top_k_benchmark(index, main_table, 10) << "                 " << std::setw(8) << top_k_benchmark(index, main_table, 100) << std::endl;
+    std::cout << "Ascending values:   " << std::setw(8) << top_k_benchmark(ascending_index, ascending_table, 10) << "                 " << std::setw(8) << top_k_benchmark(ascending_index, ascending_table, 100) << std::endl;
+    std::cout << "Descending values:  " << std::setw(8) << top_k_benchmark(descending_index, descending_table, 10) << "                 " << std::setw(8) << top_k_benchmark(descending_index, descending_table, 100) << std::endl;
+    auto random_top_changes = index.temporal_top_k(0, 100).events.size();
+    std::cout << "Change events of the random top 100: " << random_top_changes << " instead of " << 100ull * NUMBER_OF_VERSIONS << " row ids" << std::endl;
+    std::cout << std::endl;
+    std::cout << std::endl;
+// ----------------------------------------------------------------
+
+
+
 // ------------------ Benchmarking Temporal Join --------------------
     std::cout << "Temporal Join testing" << std::endl;
-    std::cout << "Random on random:        "; std::cout << temporal_join_benchmark(index, index2, main_table, second_table) << std::endl;
-    std::cout << "Random on ascending:     "; std::cout << temporal_join_benchmark(index, ascending_index, main_table, ascending_table) << std::endl;
-    std::cout << "Random on descending:    "; std::cout << temporal_join_benchmark(index, descending_index, main_table, descending_table) << std::endl;
-    std::cout << "Ascending on descending: "; std::cout << temporal_join_benchmark(ascending_index, descending_index, ascending_table, descending_table) << std::endl;
+    std::cout << "                         Materialized Join      Join Sum Pushdown" << std::endl;
+    std::cout << "Random on random:        " << std::setw(8) << temporal_join_benchmark(index, index2, main_table, second_table) << "               " << std::setw(8) << temporal_join_sum_benchmark(index, index2, main_table, second_table) << std::endl;
+    std::cout << "Random on ascending:     " << std::setw(8) << temporal_join_benchmark(index, ascending_index, main_table, ascending_table) << "               " << std::setw(8) << temporal_join_sum_benchmark(index, ascending_index, main_table, ascending_table) << std::endl;
+    std::cout << "Random on descending:    " << std::setw(8) << temporal_join_benchmark(index, descending_index, main_table, descending_table) << "               " << std::setw(8) << temporal_join_sum_benchmark(index, descending_index, main_table, descending_table) << std::endl;
+    std::cout << "Ascending on descending: " << std::setw(8) << temporal_join_benchmark(ascending_index, descending_index, ascending_table, descending_table) << "               " << std::setw(8) << temporal_join_sum_benchmark(ascending_index, descending_index, ascending_table, descending_table) << std::endl;
+// ----------------------------------------------------------------
+
+
+// ------------------ Benchmarking Compressed Events ---------------
+    std::cout << std::endl;
+    std::cout << "Compressed events testing on random values" << std::endl;
+    TimelineIndex compressed_index(main_table);
+    auto plain_events = compressed_index.memory_usage().version_map.events;
+    compressed_index.compress_events();
+    auto compressed_events = compressed_index.memory_usage().version_map.events;
+
+    std::cout << "                  Plain Events      Compressed Events" << std::endl;
+    std::cout << "Event bytes:        " << std::setw(8) << plain_events << "          " << std::setw(8) << compressed_events << std::endl;
+    std::cout << "Time Travel:        " << std::setw(8) << random_main_travel << "          " << std::setw(8) << time_travel_benchmark(compressed_index, main_table, &TimelineIndex::time_travel) << std::endl;
+    std::cout << "Temporal Sum:       " << std::setw(8) << random_main_sum << "          " << std::setw(8) << temporal_sum_benchmark(compressed_index, main_table, &TimelineIndex::temporal_sum) << std::endl;
+    std::cout << "Temporal Max:       " << std::setw(8) << random_main_max << "          " << std::setw(8) << temporal_max_benchmark(compressed_index, main_table, &TimelineIndex::temporal_max) << std::endl;
+// ----------------------------------------------------------------
+
+
+
+// ------------------ Benchmarking Materialized Aggregates ---------
+    std::cout << std::endl;
+    std::cout << "Materialized aggregates testing on random values, appending " << ITERATIONS << " versions" << std::endl;
+    TimelineIndex materialized_index(main_table);
+    start = std::chrono::high_resolution_clock::now();
+    materialized_index.materialize_aggregate(0);
+    end = std::chrono::high_resolution_clock::now();
+    std::cout << "Registration:              " << std::setw(8) << std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() << std::endl;
+
+    // every appended version deletes one row that is still alive
+    std::vector<row_id_type> live_rows;
+    for(row_id_type i=0; i<main_table.tuples.size() && live_rows.size() < ITERATIONS; i++) {
+        if(!main_table.tuples[i].second.end.has_value()) live_rows.push_back(i);
+    }
+    start = std::chrono::high_resolution_clock::now();
+    for(auto row_id : live_rows) {
+        std::vector<Event> events{Event(row_id, NO_ROW, EventType::DELETE)};
+        materialized_index.append_version(events);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    std::cout << "Append per version:        " << std::setw(8) << std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() / std::max<uint64_t>(live_rows.size(), 1) << std::endl;
+
+    start = std::chrono::high_resolution_clock::now();
+    auto recomputed_sum = materialized_index.temporal_sum(0);
+    end = std::chrono::high_resolution_clock::now();
+    std::cout << "Recomputed Temporal Sum:   " << std::setw(8) << std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() << std::endl;
+
+    start = std::chrono::high_resolution_clock::now();
+    uint64_t materialized_total = 0;
+    for(version i=0; i<materialized_index.get_current_version(); i++) {
+        materialized_total += materialized_index.get_materialized(0, i).sum;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    std::cout << "Materialized Temporal Sum: " << std::setw(8) << std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() << std::endl;
+
+#ifdef DEBUG
+    assert(materialized_index.get_materialized_series(0, AggregateType::SUM) == recomputed_sum);
+    assert(materialized_total == std::accumulate(recomputed_sum.begin(), recomputed_sum.end(), 0ull));
+    assert(materialized_index.get_materialized_series(0, AggregateType::MAX) == materialized_index.temporal_max(0));
+#endif
 // ----------------------------------------------------------------
 
 
+
+// ------------------ Benchmarking Retention ----------------------
+    std::cout << std::endl;
+    std::cout << "Retention testing, dropping the first half of the random history" << std::endl;
+    start = std::chrono::high_resolution_clock::now();
+    auto base_version = index.drop_versions_before(NUMBER_OF_VERSIONS / 2, true);
+    end = std::chrono::high_resolution_clock::now();
+    auto compacted_memory = index.memory_usage();
+    std::cout << "New base version: " << base_version << std::endl;
+    std::cout << "Compaction:       " << std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() << std::endl;
+    std::cout << "Events:       " << std::setw(12) << compacted_memory.version_map.events << std::endl;
+    std::cout << "Versions:     " << std::setw(12) << compacted_memory.version_map.versions << std::endl;
+    std::cout << "Checkpoints:  " << std::setw(12) << compacted_memory.checkpoints_total() << " (" << compacted_memory.checkpoints.size() << " checkpoints)" << std::endl;
+    std::cout << "Table rows:   " << std::setw(12) << compacted_memory.table.rows << std::endl;
+
+#ifdef DEBUG
+    for(uint32_t i=base_version; i<NUMBER_OF_VERSIONS; i+=NUMBER_OF_VERSIONS/ITERATIONS) {
+        assert(index.time_travel(i) == main_table.time_travel(i));
+    }
+#endif
+// ----------------------------------------------------------------
+
+
+#ifdef STATISTICS
+// ------------------ Query Statistics ----------------------------
+    std::cout << std::endl;
+    std::cout << "Statistics of the random index" << std::endl;
+    index.get_statistics().print(std::cout);
+// ----------------------------------------------------------------
+#endif
+
+
 }
@@ -0,0 +1,49 @@
+#include "TemporalTable.h"
+#include "TimelineIndex.h"
+#include "TableLoader.h"
+#include "QueryServer.h"
+#include "BenchmarkTables.h"
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+
+// usage: TimelineIndexServer [socket path] [binary table file] [number of versions of the file]
+int main(int argc, char** argv) {
+    std::string socket_path = argc > 1 ? argv[1] : "/tmp/timeline_index.sock";
+
+    // the signals are handled by sigwait below, all threads started later inherit the mask
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::unique_ptr<TemporalTable> table;
+    std::unique_ptr<TimelineIndex> index;
+    if(argc > 3) {
+        table = std::make_unique<TemporalTable>(std::stoul(argv[3]), 0);
+        auto histogram = TableLoader(argv[2], FileFormat::BINARY).load(*table, true);
+        index = std::make_unique<TimelineIndex>(*table, histogram);
+    } else {
+        table = std::make_unique<TemporalTable>(NUMBER_OF_VERSIONS, TEMPORAL_TABLE_SIZE);
+        std::srand(42);
+        init_random_temporal_table(*table);
+        index = std::make_unique<TimelineIndex>(*table);
+    }
+    index->set_snapshot_cache_budget(SNAPSHOT_CACHE_BUDGET);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    QueryServer server(*index, socket_path);
+    std::cout << "Serving " << table->get_table_size() << " rows and " << index->get_current_version() << " versions on " << socket_path
+              << ", built in " << std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count() << " ms" << std::endl;
+
+    int signal;
+    sigwait(&signals, &signal);
+    server.stop();
+    return 0;
+}